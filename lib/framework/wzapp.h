@@ -67,6 +67,7 @@ WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data);
 WZ_DECL_NONNULL(1) int wzThreadJoin(WZ_THREAD *thread);
 WZ_DECL_NONNULL(1) void wzThreadStart(WZ_THREAD *thread);
 void wzYieldCurrentThread();
+int wzGetCpuCount();  ///< Number of logical CPU cores, at least 1.
 WZ_MUTEX *wzMutexCreate();
 WZ_DECL_NONNULL(1) void wzMutexDestroy(WZ_MUTEX *mutex);
 WZ_DECL_NONNULL(1) void wzMutexLock(WZ_MUTEX *mutex);
@@ -1063,6 +1063,11 @@ void wzYieldCurrentThread()
 #endif
 }
 
+int wzGetCpuCount()
+{
+	return std::max(QThread::idealThreadCount(), 1);
+}
+
 WZ_MUTEX *wzMutexCreate()
 {
 	return new WZ_MUTEX;
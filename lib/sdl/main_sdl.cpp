@@ -517,6 +517,11 @@ void wzYieldCurrentThread()
 	SDL_Delay(40);
 }
 
+int wzGetCpuCount()
+{
+	return std::max(SDL_GetCPUCount(), 1);
+}
+
 WZ_MUTEX *wzMutexCreate()
 {
 	return (WZ_MUTEX *)SDL_CreateMutex();
@@ -543,7 +543,7 @@ static bool actionRemoveDroidsFromBuildPos(unsigned player, Vector2i pos, uint16
 	unsigned structureMaxRadius = iHypot(world_coord(b.size) / 2) + 1; // +1 since iHypot rounds down.
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(structureCentre.x, structureCentre.y, structureMaxRadius);
+	gridFindObjects(gridList, structureCentre.x, structureCentre.y, structureMaxRadius);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		DROID *droid = castDroid(*gi);
@@ -32,6 +32,9 @@
 #include "mapgrid.h"
 #include "map.h"
 #include "projectile.h"
+#include "workerpool.h"
+
+#include <unordered_map>
 
 /* Weights used for target selection code,
  * target distance is used as 'common currency'
@@ -520,6 +523,130 @@ static SDWORD targetAttackWeight(BASE_OBJECT *psTarget, BASE_OBJECT *psAttacker,
 }
 
 
+/// A search for objects near a droid, started by aiPrepareTargetSearches.
+struct TargetSearch
+{
+	DROID    *psDroid;
+	Vector2i pos;
+	int      range;
+	unsigned firstObject, lastObject;  ///< The objects found, in the objects of the TargetTask.
+};
+/// Objects found by the searches targetSearches[first] to targetSearches[first + TARGET_TASK_SIZE - 1].
+struct TargetTask
+{
+	GridList objects;
+	GridList gridList;
+};
+static const unsigned TARGET_TASK_SIZE = 64;  ///< Number of searches in each task.
+static std::vector<TargetSearch> targetSearches;
+static std::vector<TargetTask> targetTasks;
+static std::unordered_map<DROID const *, unsigned> firstTargetSearch;  ///< Where the searches of each droid start in targetSearches.
+
+static int aiTargetSearchRange(DROID *psDroid, int weapon_slot, int extraRange)
+{
+	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
+	return std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+}
+
+/// Whether aiBestNearestTarget is likely to be called for the droid, going by what it is doing before it is updated.
+static bool aiDroidMayLookForTargets(DROID *psDroid)
+{
+	if (isDead((BASE_OBJECT *)psDroid) || vtolEmpty(psDroid)
+	    || ((psDroid->asWeaps[0].nStat == 0 || psDroid->numWeaps == 0) && psDroid->droidType != DROID_SENSOR))
+	{
+		return false;
+	}
+	switch (psDroid->action)
+	{
+	case DACTION_NONE:
+	case DACTION_WAITFORREPAIR:
+	case DACTION_MOVE:
+	case DACTION_MOVEFIRE:
+	case DACTION_ATTACK:
+	case DACTION_MOVETOATTACK:
+	case DACTION_ROTATETOATTACK:
+	case DACTION_OBSERVE:
+	case DACTION_DROIDREPAIR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void aiPrepareTargetSearches()
+{
+	// Only the searches are done here, since they depend on the grid, which doesn't change until the next gridReset. Choosing
+	// the targets also depends on what droids updated earlier in the tick did, so is left to aiBestNearestTarget.
+	aiForgetTargetSearches();
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if (!aiDroidMayLookForTargets(psDroid))
+			{
+				continue;
+			}
+			unsigned first = targetSearches.size();
+			firstTargetSearch[psDroid] = first;
+			for (int weapon_slot = 0; weapon_slot < std::max<int>(psDroid->numWeaps, 1); ++weapon_slot)
+			{
+				TargetSearch search = {psDroid, psDroid->pos.xy, aiTargetSearchRange(psDroid, weapon_slot, 0), 0, 0};
+				auto sameRange = [&](TargetSearch const &other) { return other.range == search.range; };
+				if (std::none_of(targetSearches.begin() + first, targetSearches.end(), sameRange))  // Weapons often have the same range.
+				{
+					targetSearches.push_back(search);
+				}
+			}
+		}
+	}
+
+	unsigned numTasks = (targetSearches.size() + TARGET_TASK_SIZE - 1) / TARGET_TASK_SIZE;
+	if (targetTasks.size() < numTasks)
+	{
+		targetTasks.resize(numTasks);
+	}
+	workerPoolRun(numTasks, [](unsigned n)
+	{
+		TargetTask &task = targetTasks[n];
+		task.objects.clear();
+		unsigned end = std::min<unsigned>((n + 1) * TARGET_TASK_SIZE, targetSearches.size());
+		for (unsigned i = n * TARGET_TASK_SIZE; i < end; ++i)
+		{
+			TargetSearch &search = targetSearches[i];
+			gridFindNearbyObjects(task.gridList, search.pos.x, search.pos.y, search.range);
+			search.firstObject = task.objects.size();
+			task.objects.insert(task.objects.end(), task.gridList.begin(), task.gridList.end());
+			search.lastObject = task.objects.size();
+		}
+	});
+}
+
+void aiForgetTargetSearches()
+{
+	targetSearches.clear();
+	firstTargetSearch.clear();
+}
+
+/// Same as gridFindObjects around the droid, but uses the search from aiPrepareTargetSearches, if there is one.
+static void aiFindTargetObjects(GridList &gridList, DROID *psDroid, int range)
+{
+	auto first = firstTargetSearch.find(psDroid);
+	if (first != firstTargetSearch.end())
+	{
+		for (unsigned i = first->second; i < targetSearches.size() && targetSearches[i].psDroid == psDroid; ++i)
+		{
+			TargetSearch const &search = targetSearches[i];
+			if (search.pos == Vector2i(psDroid->pos.xy) && search.range == range)
+			{
+				GridList const &objects = targetTasks[i / TARGET_TASK_SIZE].objects;
+				gridFilterObjects(gridList, objects.begin() + search.firstObject, objects.begin() + search.lastObject, search.pos.x, search.pos.y, range);
+				return;
+			}
+		}
+	}
+	gridFindObjects(gridList, psDroid->pos.x, psDroid->pos.y, range);
+}
+
 // Find the best nearest target for a droid.
 // If extraRange is higher than zero, then this is the range it accepts for movement to target.
 // Returns integer representing target priority, -1 if failed
@@ -558,11 +685,10 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 
 	electronic = electronicDroid(psDroid);
 
-	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
-	int droidRange = std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+	int droidRange = aiTargetSearchRange(psDroid, weapon_slot, extraRange);
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
+	aiFindTargetObjects(gridList, psDroid, droidRange);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *friendlyObj = NULL;
@@ -900,7 +1026,7 @@ bool aiChooseTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget, int weapon_slot
 			}
 
 			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, srange);
+			gridFindObjects(gridList, psObj->pos.x, psObj->pos.y, srange);
 			for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 			{
 				BASE_OBJECT *psCurr = *gi;
@@ -983,7 +1109,7 @@ bool aiChooseSensorTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget)
 		int		tarDist = SDWORD_MAX;
 
 		static GridList gridList;  // static to avoid allocations.
-		gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, objSensorRange(psObj));
+		gridFindObjects(gridList, psObj->pos.x, psObj->pos.y, objSensorRange(psObj));
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psCurr = *gi;
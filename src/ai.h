@@ -63,6 +63,13 @@ bool aiShutdown(void);
 /* Do the AI for a droid */
 void aiUpdateDroid(DROID *psDroid);
 
+/** Starts the target searches which droids are likely to do in droidUpdate this tick, on the worker threads. Must be called
+ *  after gridReset. aiBestNearestTarget uses the results, until aiForgetTargetSearches is called, which must be before the next
+ *  gridReset.
+ */
+void aiPrepareTargetSearches();
+void aiForgetTargetSearches();
+
 // Find the nearest best target for a droid
 // returns integer representing quality of choice, -1 if failed
 int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, int extraRange = 0);
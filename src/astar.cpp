@@ -35,16 +35,29 @@
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
- *  stored in the PathExploredTile 2D array of tiles.
+ *  Up to 8 pathfinding maps from A* are cached per PathfindCache, in a LRU list.  The
+ *  PathNode heap contains the priority-heap-sorted nodes which are to be explored. The
+ *  path back is stored in the PathExploredTile 2D array of tiles.
+ *  * For long routes, the route is first planned on the cluster graph (PathHierarchy),
+ *    and A* only explores the clusters that route passes through.
+ *  * Routes with FMT_MOVE and no danger map are found with Jump Point Search instead,
+ *    falling back to A* if there is no route. After several such routes in a row to
+ *    the same destination, a flow field is built for it instead.
+ *  * Contexts from earlier ticks are kept, if the blocking map hasn't changed near any
+ *    tile they have explored since then.
  */
 
 #ifndef WZ_TESTING
 #include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
 
 #include "astar.h"
 #include "map.h"
+#include "flowfield.h"
+#include "jps.h"
+#include "pathcost.h"
+#include "pathhierarchy.h"
+#include "tilebitmap.h"
 #endif
 
 #include <list>
@@ -101,12 +114,13 @@ struct PathNode
 };
 struct PathExploredTile
 {
-	PathExploredTile() : iteration(0xFFFF), dx(0), dy(0), dist(0), visited(false) {}
+	PathExploredTile() : iteration(0xFFFF), dx(0), dy(0), dist(0), visited(false), heapIndex(0) {}
 
 	uint16_t iteration;
 	int8_t   dx, dy;                // Offset from previous point in the route.
 	unsigned dist;                  // Shortest known distance to tile.
 	bool     visited;
+	unsigned heapIndex;             // Position in PathfindContext::nodes, if not visited.
 };
 
 struct PathBlockingType
@@ -128,8 +142,12 @@ struct PathBlockingMap
 	}
 
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	TileBitmap map;
+	TileBitmap dangerMap;	// using threatBits
+	std::shared_ptr<PathHierarchy const> hierarchy;  ///< Cluster graph of map, for long routes. Built by fpathGetHierarchy when first needed.
+	wz::mutex hierarchyMutex;                  ///< Guards hierarchy, since jobs using the same map can run on different threads.
+	std::weak_ptr<PathBlockingMap> previous;   ///< Map of the same type, built before this one.
+	TileBitmap changed;                        ///< Tiles where map or dangerMap differ from previous. Empty if there is no previous.
 };
 
 struct PathNonblockingArea
@@ -144,6 +162,10 @@ struct PathNonblockingArea
 	{
 		return !(*this == z);
 	}
+	bool isEmpty() const
+	{
+		return x1 >= x2 || y1 >= y2;
+	}
 	bool isNonblocking(int x, int y) const
 	{
 		return x >= x1 && x < x2 && y >= y1 && y < y2;
@@ -163,17 +185,42 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		if (x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y))
+		{
+			return true;
+		}
+		return !corridor.empty() && !corridor[PathHierarchy::clusterOf(x, y, mapWidth)];
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
 	}
 	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
 		// Must check myGameTime == blockingMap_->type.gameTime, otherwise blockingMap could be a deleted pointer which coincidentally compares equal to the valid pointer blockingMap_.
 		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
 	}
+	/// Returns true if the context was made with the map before blockingMap_, and nothing it looked at has changed since.
+	bool matchesPrevious(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
+	{
+		if (tileS != tileS_ || dstIgnore != dstIgnore_ || blockingMap_->changed.empty() || blockingMap_->previous.lock() != blockingMap)
+		{
+			return false;
+		}
+		PathExploredTile const &start = map[tileS.x + tileS.y * mapWidth];
+		if (start.iteration != iteration || start.dist != 0)
+		{
+			return false;  // Started from the nearest reachable tile to tileS, which can change even if nothing explored has changed.
+		}
+		// Explored tiles were only added after checking their neighbours, so also check one tile around them.
+		return !blockingMap_->changed.anyInRect(exploredMin.x - 1, exploredMin.y - 1, exploredMax.x + 2, exploredMax.y + 2);
+	}
+	/// Keeps the explored tiles, but uses blockingMap_ for exploring further.
+	void reassign(std::shared_ptr<PathBlockingMap> &blockingMap_)
+	{
+		blockingMap = blockingMap_;
+		myGameTime = blockingMap->type.gameTime;
+	}
 	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_)
 	{
 		blockingMap = blockingMap_;
@@ -181,6 +228,9 @@ struct PathfindContext
 		dstIgnore = dstIgnore_;
 		myGameTime = blockingMap->type.gameTime;
 		nodes.clear();
+		corridor.clear();
+		exploredMin = PathCoord(INT16_MAX, INT16_MAX);
+		exploredMax = PathCoord(INT16_MIN, INT16_MIN);
 
 		// Make the iteration not match any value of iteration in map.
 		if (++iteration == 0xFFFF)
@@ -196,25 +246,44 @@ struct PathfindContext
 
 	PathCoord       nearestCoord;         // Nearest reachable tile to destination.
 
+	PathCoord       exploredMin, exploredMax;  // Bounding box of tiles in map.
+
 	/** Counter to implement lazy deletion from map.
 	 *
 	 *  @see fpathTableReset
 	 */
 	uint16_t        iteration;
 
-	std::vector<PathNode> nodes;        ///< Edge of explored region of the map.
+	std::vector<PathNode> nodes;        ///< Edge of explored region of the map. Heap with the best node at the front, at most one node per tile.
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+	std::vector<bool> corridor;         ///< Clusters of blockingMap->hierarchy which may be explored, or empty to explore everywhere.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/// Number of routes in a row to the same destination, after which a flow field is built for it.
+#define FLOWFIELD_MIN_ROUTES 4
+
+struct PathfindCache
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	unsigned maxContexts;                 ///< Contexts to keep, overwriting the oldest when making a new one.
+	std::vector<Vector2i> path;           ///< Scratch space for building routes, kept to save allocations.
+	std::vector<bool> corridor;           ///< Scratch space for planning routes on the cluster graph.
+	JumpPointSearch jps;                  ///< For routes where all open tiles cost the same.
+	FlowField flowField;                  ///< For routes where all open tiles cost the same, to a popular destination.
+	std::shared_ptr<PathBlockingMap> flowFieldMap;  ///< Blocking map flowField was built on.
+	PathCoord lastDest;                   ///< Destination of the last route which could use flowField.
+	unsigned sameDestCount;               ///< Number of routes in a row to lastDest.
+	PathfindStats stats;
+};
 
 /// Lists of blocking maps from current tick.
 static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
 /// Game time for all blocking maps in fpathBlockingMaps.
 static uint32_t fpathCurrentGameTime;
+/// Most recent blocking map of each kind, for updating the cluster graph instead of building it from scratch.
+static std::vector<std::shared_ptr<PathBlockingMap>> fpathPreviousBlockingMaps;
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -230,24 +299,135 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
+/// Returns a mask with bit dir set if the tile at p + aDirOffset[dir] is blocked.
+static inline unsigned fpathBlockedNeighbours(PathfindContext const &context, PathCoord p)
+{
+	if (p.x >= 1 && p.y >= 1 && p.x < mapWidth - 1 && p.y < mapHeight - 1 && context.dstIgnore.isEmpty() && context.corridor.empty())
+	{
+		// Read the 3 rows of the blocking map directly.
+		TileBitmap const &map = context.blockingMap->map;
+		unsigned above = map.get3(p.x, p.y - 1), middle = map.get3(p.x, p.y), below = map.get3(p.x, p.y + 1);
+		return (below >> 1 & 1) | (below & 1) << 1 | (middle & 1) << 2 | (above & 1) << 3 |
+		       (above >> 1 & 1) << 4 | (above >> 2 & 1) << 5 | (middle >> 2 & 1) << 6 | (below >> 2 & 1) << 7;
+	}
+	unsigned blockedDirs = 0;
+	for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+	{
+		if (context.isBlocked(p.x + aDirOffset[dir].x, p.y + aDirOffset[dir].y))
+		{
+			blockedDirs |= 1 << dir;
+		}
+	}
+	return blockedDirs;
+}
+
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
 	fpathBlockingMaps.clear();
+	fpathPreviousBlockingMaps.clear();
+}
+
+PathfindCache *fpathCreateCache(unsigned maxContexts)
+{
+	ASSERT(maxContexts > 0, "A cache needs room for at least one context.");
+	PathfindCache *cache = new PathfindCache;
+	cache->maxContexts = std::max(maxContexts, 1u);
+	cache->lastDest = PathCoord(-1, -1);
+	cache->sameDestCount = 0;
+	cache->stats.nodesExpanded = 0;
+	cache->stats.flowFieldsBuilt = 0;
+	cache->stats.contextsReused = 0;
+	cache->stats.contextsCreated = 0;
+	return cache;
+}
+
+void fpathDestroyCache(PathfindCache *cache)
+{
+	delete cache;
+}
+
+void fpathClearCache(PathfindCache *cache)
+{
+	cache->contexts.clear();
+	std::vector<Vector2i>().swap(cache->path);
+	cache->jps.clear();
+	cache->flowField.clear();
+	cache->flowFieldMap.reset();
+	cache->lastDest = PathCoord(-1, -1);
+	cache->sameDestCount = 0;
+}
+
+PathfindStats fpathCacheStats(PathfindCache const *cache)
+{
+	return cache->stats;
+}
+
+/// Puts node at position index in the node heap, and remembers the position in the explored tile.
+static inline void fpathPlaceNode(PathfindContext &context, unsigned index, PathNode const &node)
+{
+	context.nodes[index] = node;
+	context.map[node.p.x + node.p.y * mapWidth].heapIndex = index;
+}
+
+/// Moves the node at position index towards the front of the node heap, until its parent is better.
+static inline void fpathSiftNodeUp(PathfindContext &context, unsigned index)
+{
+	PathNode node = context.nodes[index];
+	while (index > 0)
+	{
+		unsigned parent = (index - 1) / 2;
+		if (!(context.nodes[parent] < node))
+		{
+			break;
+		}
+		fpathPlaceNode(context, index, context.nodes[parent]);
+		index = parent;
+	}
+	fpathPlaceNode(context, index, node);
+}
+
+/// Moves the node at position index towards the back of the node heap, until its children are worse.
+static inline void fpathSiftNodeDown(PathfindContext &context, unsigned index)
+{
+	PathNode node = context.nodes[index];
+	unsigned size = context.nodes.size();
+	while (true)
+	{
+		unsigned child = index * 2 + 1;
+		if (child >= size)
+		{
+			break;
+		}
+		if (child + 1 < size && context.nodes[child] < context.nodes[child + 1])
+		{
+			++child;  // Right child is better.
+		}
+		if (!(node < context.nodes[child]))
+		{
+			break;
+		}
+		fpathPlaceNode(context, index, context.nodes[child]);
+		index = child;
+	}
+	fpathPlaceNode(context, index, node);
 }
 
 /** Get the nearest entry in the open list
  */
 /// Takes the current best node, and removes from the node heap.
-static inline PathNode fpathTakeNode(std::vector<PathNode> &nodes)
+static inline PathNode fpathTakeNode(PathfindContext &context)
 {
 	// find the node with the lowest distance
 	// if equal totals, give preference to node closer to target
-	PathNode ret = nodes.front();
+	PathNode ret = context.nodes.front();
 
-	// remove the node from the list
-	std::pop_heap(nodes.begin(), nodes.end());  // Move the best node from the front of nodes to the back of nodes, preserving the heap properties, setting the front to the next best node.
-	nodes.pop_back();                           // Pop the best node (which we will be returning).
+	// remove the node from the list, and fill the gap with the last node
+	context.nodes.front() = context.nodes.back();
+	context.nodes.pop_back();
+	if (!context.nodes.empty())
+	{
+		fpathSiftNodeDown(context, 0);
+	}
 
 	return ret;
 }
@@ -256,9 +436,7 @@ static inline PathNode fpathTakeNode(std::vector<PathNode> &nodes)
  */
 static inline unsigned WZ_DECL_PURE fpathEstimate(PathCoord s, PathCoord f)
 {
-	// Cost of moving horizontal/vertical = 70*2, cost of moving diagonal = 99*2, 99/70 = 1.41428571... ≈ √2 = 1.41421356...
-	unsigned xDelta = abs(s.x - f.x), yDelta = abs(s.y - f.y);
-	return std::min(xDelta, yDelta) * (198 - 140) + std::max(xDelta, yDelta) * 140;
+	return fpathMoveCost(s.x - f.x, s.y - f.y);
 }
 static inline unsigned WZ_DECL_PURE fpathGoodEstimate(PathCoord s, PathCoord f)
 {
@@ -324,9 +502,19 @@ static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCo
 		{
 			return;  // A different path to this tile is shorter.
 		}
+
+		// Found a shorter path to a tile already in the node heap, so update the node instead of adding another one.
+		expl.dx = delta.x;
+		expl.dy = delta.y;
+		expl.dist = node.dist;
+		context.nodes[expl.heapIndex] = node;
+		fpathSiftNodeUp(context, expl.heapIndex);  // Same estimate to the end, shorter distance so far, so node can only have got better.
+		return;
 	}
 
 	// Remember where we have been, and remember the way back.
+	context.exploredMin = PathCoord(std::min(context.exploredMin.x, pos.x), std::min(context.exploredMin.y, pos.y));
+	context.exploredMax = PathCoord(std::max(context.exploredMax.x, pos.x), std::max(context.exploredMax.y, pos.y));
 	expl.iteration = context.iteration;
 	expl.dx = delta.x;
 	expl.dy = delta.y;
@@ -334,8 +522,8 @@ static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCo
 	expl.visited = false;
 
 	// Add the node to the node heap.
-	context.nodes.push_back(node);                               // Add the new node to nodes.
-	std::push_heap(context.nodes.begin(), context.nodes.end());  // Move the new node to the right place in the heap.
+	context.nodes.push_back(node);                       // Add the new node to nodes.
+	fpathSiftNodeUp(context, context.nodes.size() - 1);  // Move the new node to the right place in the heap.
 }
 
 /// Recalculates estimates to new tileF tile.
@@ -347,11 +535,14 @@ static void fpathAStarReestimate(PathfindContext &context, PathCoord tileF)
 	}
 
 	// Changing the estimates breaks the heap ordering. Fix the heap ordering.
-	std::make_heap(context.nodes.begin(), context.nodes.end());
+	for (unsigned index = context.nodes.size() / 2; index-- > 0;)
+	{
+		fpathSiftNodeDown(context, index);
+	}
 }
 
-/// Returns nearest explored tile to tileF.
-static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
+/// Returns nearest explored tile to tileF. Adds the number of tiles taken from the open list to nodesExpanded.
+static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF, unsigned &nodesExpanded)
 {
 	PathCoord       nearestCoord(0, 0);
 	unsigned        nearestDist = 0xFFFFFFFF;
@@ -360,12 +551,9 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	bool foundIt = false;
 	while (!context.nodes.empty() && !foundIt)
 	{
-		PathNode node = fpathTakeNode(context.nodes);
-		if (context.map[node.p.x + node.p.y * mapWidth].visited)
-		{
-			continue;  // Already been here.
-		}
+		PathNode node = fpathTakeNode(context);
 		context.map[node.p.x + node.p.y * mapWidth].visited = true;
+		++nodesExpanded;
 
 		// note the nearest node to the target so far
 		if (node.est - node.dist < nearestDist)
@@ -381,6 +569,8 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			foundIt = true;  // Break out of loop, but not before inserting neighbour nodes, since the neighbours may be important if the context gets reused.
 		}
 
+		unsigned blockedDirs = fpathBlockedNeighbours(context, node.p);
+
 		// loop through possible moves in 8 directions to find a valid move
 		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
 		{
@@ -398,25 +588,15 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			*/
 			if (dir % 2 != 0 && !context.dstIgnore.isNonblocking(node.p.x, node.p.y) && !context.dstIgnore.isNonblocking(x, y))
 			{
-				int x, y;
-
 				// We cannot cut corners
-				x = node.p.x + aDirOffset[(dir + 1) % 8].x;
-				y = node.p.y + aDirOffset[(dir + 1) % 8].y;
-				if (context.isBlocked(x, y))
-				{
-					continue;
-				}
-				x = node.p.x + aDirOffset[(dir + 7) % 8].x;
-				y = node.p.y + aDirOffset[(dir + 7) % 8].y;
-				if (context.isBlocked(x, y))
+				if ((blockedDirs & (1 << (dir + 1) % 8 | 1 << (dir + 7) % 8)) != 0)
 				{
 					continue;
 				}
 			}
 
 			// See if the node is a blocking tile
-			if (context.isBlocked(x, y))
+			if ((blockedDirs & 1 << dir) != 0)
 			{
 				// tile is blocked, skip it
 				continue;
@@ -439,8 +619,93 @@ static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlock
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
+/** Returns the cluster graph of blockMap, building it if no earlier route needed it. Returns NULL if there is a dangerMap, since
+ *  the graph ignores danger. Function is thread-safe.
+ */
+static std::shared_ptr<PathHierarchy const> fpathGetHierarchy(PathBlockingMap &blockMap)
+{
+	if (!blockMap.dangerMap.empty())
+	{
+		return nullptr;
+	}
+	std::lock_guard<wz::mutex> lock(blockMap.hierarchyMutex);
+	if (blockMap.hierarchy == nullptr)
+	{
+		// Start from the graph of the map from an earlier tick, if that map is still around, so only the clusters which changed since
+		// then are rebuilt. The graph only depends on the contents of the map, so this doesn't change which routes are found.
+		std::shared_ptr<PathBlockingMap> previous = blockMap.previous.lock();
+		std::shared_ptr<PathHierarchy const> previousHierarchy = previous != nullptr ? fpathGetHierarchy(*previous) : nullptr;
+		if (previousHierarchy != nullptr && !blockMap.changed.anyInRect(0, 0, mapWidth, mapHeight))
+		{
+			blockMap.hierarchy = previousHierarchy;  // Nothing changed, so share the graph.
+		}
+		else
+		{
+			blockMap.hierarchy = std::make_shared<PathHierarchy>(blockMap.map, previousHierarchy.get(), previousHierarchy != nullptr ? &blockMap.changed : nullptr);
+		}
+	}
+	return blockMap.hierarchy;
+}
+
+/// Returns true if cache->flowField is for routes to tileDest on blockingMap, building it if there have been enough routes to tileDest.
+static bool fpathFlowField(PathfindCache *cache, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileDest)
+{
+	cache->sameDestCount = cache->lastDest == tileDest ? cache->sameDestCount + 1 : 1;
+	cache->lastDest = tileDest;
+
+	FlowField &field = cache->flowField;
+	if (!field.empty() && field.getDestination() == Vector2i(tileDest.x, tileDest.y))
+	{
+		if (cache->flowFieldMap == blockingMap)
+		{
+			return true;
+		}
+		if (!blockingMap->changed.empty() && blockingMap->previous.lock() == cache->flowFieldMap && !blockingMap->changed.anyInRect(0, 0, mapWidth, mapHeight))
+		{
+			// Built on the map from an earlier tick, but nothing has changed since then.
+			cache->flowFieldMap = blockingMap;
+			field.setMap(blockingMap->map);
+			return true;
+		}
+	}
+	if (cache->sameDestCount < FLOWFIELD_MIN_ROUTES)
+	{
+		return false;  // Not worth building a field for a few routes.
+	}
+
+	field.build(blockingMap->map, Vector2i(tileDest.x, tileDest.y));
+	cache->flowFieldMap = blockingMap;
+	++cache->stats.flowFieldsBuilt;
+	return true;
+}
+
+/// Copies a route found by Jump Point Search or a flow field to psMove.
+static ASR_RETVAL fpathWaypointRoute(PathfindCache *cache, MOVE_CONTROL *psMove, PATHJOB *psJob, std::vector<Vector2i> const &jumpPoints)
+{
+	psMove->asPath = static_cast<Vector2i *>(malloc(sizeof(*psMove->asPath) * jumpPoints.size()));
+	ASSERT(psMove->asPath, "Out of memory");
+	if (!psMove->asPath)
+	{
+		fpathClearCache(cache);
+		return ASR_FAILED;
+	}
+	psMove->numPoints = jumpPoints.size();
+
+	for (unsigned i = 0; i < jumpPoints.size(); ++i)
+	{
+		psMove->asPath[i] = world_coord(jumpPoints[i]) + Vector2i(TILE_UNITS / 2, TILE_UNITS / 2);
+	}
+	// Found exact path, so use exact coordinates for last point, no reason to lose precision
+	psMove->asPath[jumpPoints.size() - 1] = Vector2i(psJob->destX, psJob->destY);
+	psMove->destination = psMove->asPath[jumpPoints.size() - 1];
+
+	return ASR_OK;
+}
+
+ASR_RETVAL fpathAStarRoute(PathfindCache *cache, MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
+	std::list<PathfindContext> &fpathContexts = cache->contexts;
+
 	ASR_RETVAL      retval = ASR_OK;
 
 	bool            mustReverse = true;
@@ -451,13 +716,40 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 	PathCoord endCoord;  // Either nearest coord (mustReverse = true) or orig (mustReverse = false).
 
+	// When all open tiles cost the same, and there is no structure at the destination, Jump Point Search is much faster. If many
+	// droids are going to the same destination, following a flow field is faster still.
+	if (psJob->moveType == FMT_MOVE && psJob->blockingMap->dangerMap.empty() && dstIgnore.isEmpty())
+	{
+		bool found;
+		if (fpathFlowField(cache, psJob->blockingMap, tileDest))
+		{
+			found = cache->flowField.route(Vector2i(tileOrig.x, tileOrig.y), cache->path);
+		}
+		else
+		{
+			found = cache->jps.route(psJob->blockingMap->map, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), cache->path);
+			cache->stats.nodesExpanded += cache->jps.nodesExpanded;
+		}
+		if (found)
+		{
+			return fpathWaypointRoute(cache, psMove, psJob, cache->path);
+		}
+		// No route, fall back to A*, which finds the nearest reachable tile.
+	}
+
 	std::list<PathfindContext>::iterator contextIterator = fpathContexts.begin();
 	for (contextIterator = fpathContexts.begin(); contextIterator != fpathContexts.end(); ++contextIterator)
 	{
 		if (!contextIterator->matches(psJob->blockingMap, tileDest, dstIgnore))
 		{
-			// This context is not for the same droid type and same destination.
-			continue;
+			if (!contextIterator->matchesPrevious(psJob->blockingMap, tileDest, dstIgnore))
+			{
+				// This context is not for the same droid type and same destination.
+				continue;
+			}
+
+			// The context is from an earlier tick, but the blocking map hasn't changed anywhere it has explored, so keep using it.
+			contextIterator->reassign(psJob->blockingMap);
 		}
 
 		// We have tried going to tileDest before.
@@ -472,7 +764,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		{
 			// Need to find the path from orig to dest, continue previous exploration.
 			fpathAStarReestimate(*contextIterator, tileOrig);
-			endCoord = fpathAStarExplore(*contextIterator, tileOrig);
+			endCoord = fpathAStarExplore(*contextIterator, tileOrig, cache->stats.nodesExpanded);
 		}
 
 		if (endCoord != tileOrig)
@@ -482,14 +774,16 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		}
 
 		mustReverse = false;  // We have the path from the nearest reachable tile to dest, to orig.
+		++cache->stats.contextsReused;
 		break;  // Found the path! Don't search more contexts.
 	}
 
 	if (contextIterator == fpathContexts.end())
 	{
 		// We did not find an appropriate context. Make one.
+		++cache->stats.contextsCreated;
 
-		if (fpathContexts.size() < 30)
+		if (fpathContexts.size() < cache->maxContexts)
 		{
 			fpathContexts.push_back(PathfindContext());
 		}
@@ -498,7 +792,16 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		// Init a new context, overwriting the oldest one if we are caching too many.
 		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
 		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
-		endCoord = fpathAStarExplore(*contextIterator, tileDest);
+
+		// For long routes, only search the clusters which the route on the cluster graph passes through. If there is no route on the
+		// graph, search everywhere, since we need the nearest reachable tile.
+		std::shared_ptr<PathHierarchy const> hierarchy = dstIgnore.isEmpty() ? fpathGetHierarchy(*psJob->blockingMap) : nullptr;
+		if (hierarchy != nullptr &&
+		    hierarchy->findCorridor(psJob->blockingMap->map, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), cache->corridor))
+		{
+			contextIterator->corridor = cache->corridor;
+		}
+		endCoord = fpathAStarExplore(*contextIterator, tileDest, cache->stats.nodesExpanded);
 		contextIterator->nearestCoord = endCoord;
 	}
 
@@ -511,7 +814,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
+	std::vector<Vector2i> &path = cache->path;
 	path.clear();
 
 	Vector2i newP;
@@ -562,7 +865,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	ASSERT(psMove->asPath, "Out of memory");
 	if (!psMove->asPath)
 	{
-		fpathHardTableReset();
+		fpathClearCache(cache);
 		return ASR_FAILED;
 	}
 
@@ -584,8 +887,10 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 		if (!context.isBlocked(tileOrig.x, tileOrig.y))  // If blocked, searching from tileDest to tileOrig wouldn't find the tileOrig tile.
 		{
-			// Next time, search starting from nearest reachable tile to the destination.
+			// Next time, search starting from nearest reachable tile to the destination, within the same clusters as this time.
+			cache->corridor.swap(context.corridor);
 			fpathInitContext(context, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore);
+			context.corridor.swap(cache->corridor);
 		}
 	}
 	else
@@ -605,6 +910,60 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+/// Sets map to fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType) for all tiles, a row at a time.
+static void fpathFillBlockingMap(TileBitmap &map, PathBlockingType const &type)
+{
+	uint8_t auxMask = fpathMoveTypeBlockingBits(type.moveType);
+	uint8_t unitbits = fpathPropulsionBlockingBits(type.propulsion);
+	if ((unitbits & FEATURE_BLOCKED) == 0)
+	{
+		auxMask = 0;  // Buildings don't matter.
+	}
+	bool scrollLimits = type.propulsion != PROPULSION_TYPE_LIFT;
+	uint8_t const *aux = psAuxMap[type.owner];
+	uint8_t const *block = psBlockMap[MAX(0, type.owner - MAX_PLAYERS)];
+
+	map.resize(mapWidth, mapHeight);
+	for (int y = 0; y < mapHeight; ++y)
+	{
+		// All tiles on the map border, and outside the scroll limits (used in campaign to partition the map), are blocking.
+		if (y < 1 || (scrollLimits && (y < scrollMinY + 1 || y >= scrollMaxY - 1)))
+		{
+			map.setRange(y, 0, mapWidth);
+			continue;
+		}
+		map.setRowFromBytes(y, aux + y * mapWidth, auxMask, block + y * mapWidth, unitbits);
+		map.setRange(y, 0, scrollLimits ? scrollMinX + 1 : 1);
+		if (scrollLimits)
+		{
+			map.setRange(y, scrollMaxX - 1, mapWidth);
+		}
+	}
+}
+
+/// Sets blockMap.changed to the tiles where blockMap differs from previous.
+static void fpathFindChangedTiles(PathBlockingMap &blockMap, PathBlockingMap const &previous)
+{
+	blockMap.changed.resize(mapWidth, mapHeight);
+	for (int y = 0; y < mapHeight; ++y)
+	{
+		uint64_t *changed = blockMap.changed.row(y);
+		uint64_t const *map = blockMap.map.row(y), *previousMap = previous.map.row(y);
+		for (int w = 0; w < blockMap.changed.rowWords(); ++w)
+		{
+			changed[w] = map[w] ^ previousMap[w];
+		}
+		if (!blockMap.dangerMap.empty())
+		{
+			uint64_t const *dangerMap = blockMap.dangerMap.row(y), *previousDangerMap = previous.dangerMap.row(y);
+			for (int w = 0; w < blockMap.changed.rowWords(); ++w)
+			{
+				changed[w] |= dangerMap[w] ^ previousDangerMap[w];
+			}
+		}
+	}
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
 	if (fpathCurrentGameTime != gameTime)
@@ -633,28 +992,38 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 
 		// blockMap now points to an empty map with no data. Fill the map.
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
-			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
-			}
+		fpathFillBlockingMap(blockMap->map, type);
+		uint32_t checksumMap = blockMap->map.checksum(), checksumDangerMap = 0;
 		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
+			TileBitmap &dangerMap = blockMap->dangerMap;
+			dangerMap.resize(mapWidth, mapHeight);
 			for (int y = 0; y < mapHeight; ++y)
-				for (int x = 0; x < mapWidth; ++x)
-				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
-				}
+			{
+				dangerMap.setRowFromBytes(y, psAuxMap[type.owner] + y * mapWidth, AUXBITS_THREAT, nullptr, 0);
+			}
+			checksumDangerMap = dangerMap.checksum();
 		}
 		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
 
+		// Find the map of the same type from an earlier tick, to see what has changed since then.
+		std::shared_ptr<PathBlockingMap> previous;
+		auto prev = std::find_if(fpathPreviousBlockingMaps.begin(), fpathPreviousBlockingMaps.end(), [&](std::shared_ptr<PathBlockingMap> const &ptr) {
+			return fpathIsEquivalentBlocking(ptr->type.propulsion, ptr->type.owner, ptr->type.moveType, type.propulsion, type.owner, type.moveType) &&
+			       ptr->dangerMap.empty() == blockMap->dangerMap.empty() && ptr->map.getWidth() == mapWidth && ptr->map.getHeight() == mapHeight;
+		});
+		if (prev != fpathPreviousBlockingMaps.end())
+		{
+			previous = *prev;
+			*prev = fpathBlockingMaps.back();
+			blockMap->previous = previous;
+			fpathFindChangedTiles(*blockMap, *previous);
+		}
+		else
+		{
+			fpathPreviousBlockingMaps.push_back(fpathBlockingMaps.back());
+		}
+
 		psJob->blockingMap = fpathBlockingMaps.back();
 	}
 	else
@@ -34,19 +34,58 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
+/** Cache of partially explored maps, reused between jobs with the same destination.
+ *
+ *  A cache must only be used by one thread at a time.
+ *
+ *  @ingroup pathfinding
+ */
+struct PathfindCache;
+
+/** Number of contexts kept by all the caches of a game together. Each context has a copy of the map, 16 bytes per tile, so this
+ *  bounds the memory used, to 32 MiB on a 256x256 map. Split between the lanes of fpath.cpp, which need several contexts each, or
+ *  droids going to the same place as each other keep overwriting each other's contexts.
+ */
+#define PATHFIND_CACHE_SIZE 32
+
+/// Creates an empty cache, for use by fpathAStarRoute, which keeps the explored regions of the last maxContexts routes.
+PathfindCache *fpathCreateCache(unsigned maxContexts);
+
+/// Frees a cache created by fpathCreateCache.
+void fpathDestroyCache(PathfindCache *cache);
+
+/// Empties a cache, releasing its memory, but does not destroy it. Routes found afterwards are the same as with a new cache.
+void fpathClearCache(PathfindCache *cache);
+
+/// Work done by fpathAStarRoute using a cache since the cache was created, for benchmarks.
+struct PathfindStats
+{
+	unsigned nodesExpanded;    ///< Tiles taken from the A* open list, plus jump points taken from the Jump Point Search open list.
+	unsigned flowFieldsBuilt;  ///< Each costs about as much as expanding every reachable tile on the map.
+	unsigned contextsReused;   ///< A* routes which continued the exploration of a cached context.
+	unsigned contextsCreated;  ///< A* routes which had to start a new context, overwriting the oldest if the cache was full.
+};
+
+/// Returns the work done using a cache.
+PathfindStats fpathCacheStats(PathfindCache const *cache);
+
 /** Use the A* algorithm to find a path
+ *
+ *  The result depends on the jobs previously routed using the same cache, so the same jobs must be given to the same cache in the
+ *  same order on all clients.
  *
  *  @ingroup pathfinding
  */
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob);
+ASR_RETVAL fpathAStarRoute(PathfindCache *cache, MOVE_CONTROL *psMove, PATHJOB *psJob);
 
 /// Call from main thread.
 /// Sets psJob->blockingMap for later use by pathfinding thread, generating the required map if not already generated.
 void fpathSetBlockingMap(PATHJOB *psJob);
 
-/** Clean up the path finding node table.
+/** Clean up the blocking maps.
  *
  *  @note Call this on shutdown to prevent memory from leaking, or if loading/saving, to prevent stale data from being reused.
+ *  @note Caches must be cleared separately, with fpathClearCache.
  *
  *  @ingroup pathfinding
  */
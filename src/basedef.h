@@ -25,6 +25,7 @@
 #define __INCLUDED_BASEDEF_H__
 
 #include "lib/framework/vector.h"
+#include "objectpool.h"
 #include "displaydef.h"
 #include "statsdef.h"
 #include "weapondef.h"
@@ -93,8 +94,10 @@ struct SIMPLE_OBJECT
 	uint32_t        time;                           ///< Game time of given space-time position.
 };
 
-#define BASEFLAG_TARGETED  0x01 ///< Whether object is targeted by a selectedPlayer droid sensor (quite the hack)
-#define BASEFLAG_DIRTY     0x02 ///< Whether certain recalculations are needed for object on frame update
+#define BASEFLAG_TARGETED     0x01 ///< Whether object is targeted by a selectedPlayer droid sensor (quite the hack)
+#define BASEFLAG_DIRTY        0x02 ///< Whether certain recalculations are needed for object on frame update
+#define BASEFLAG_REFERENCED   0x04 ///< Whether a destroyed object is still referred to by another object, so can't be freed
+#define BASEFLAG_DIRTY_VISION 0x08 ///< Whether the tiles the object can see must be recalculated, since the terrain height changed
 
 #define MAX_WEAPONS 3
 
@@ -29,6 +29,7 @@
 #include "feature.h"
 #include "intdisplay.h"
 #include "map.h"
+#include "objmem.h"
 
 
 static inline uint16_t interpolateAngle(uint16_t v1, uint16_t v2, uint32_t t1, uint32_t t2, uint32_t t)
@@ -121,6 +122,7 @@ BASE_OBJECT::~BASE_OBJECT()
 	// Make sure to get rid of some final references in the sound code to this object first
 	audio_RemoveObj(this);
 
+	objmemForgetObject(this);
 	visRemoveVisibility(this);
 	free(watchedTiles);
 
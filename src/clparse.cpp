@@ -31,6 +31,7 @@
 
 #include "clparse.h"
 #include "display3d.h"
+#include "fpath.h"
 #include "frontend.h"
 #include "keybind.h"
 #include "loadsave.h"
@@ -239,6 +240,7 @@ typedef enum
 	CLI_TEXTURECOMPRESSION,
 	CLI_NOTEXTURECOMPRESSION,
 	CLI_AUTOGAME,
+	CLI_PATHTRACE,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable(void)
@@ -272,6 +274,7 @@ static const struct poptOption *getOptionsTable(void)
 		{ "texturecompression", '\0', POPT_ARG_NONE, NULL, CLI_TEXTURECOMPRESSION, N_("Enable texture compression"), NULL },
 		{ "notexturecompression", '\0', POPT_ARG_NONE, NULL, CLI_NOTEXTURECOMPRESSION, N_("Disable texture compression"), NULL },
 		{ "autogame",   '\0', POPT_ARG_NONE,   NULL, CLI_AUTOGAME,   N_("Run games automatically for testing"), NULL },
+		{ "pathtrace",  '\0', POPT_ARG_STRING, NULL, CLI_PATHTRACE,  N_("Record path jobs to file, for benchmarking"), N_("file") },
 		// Terminating entry
 		{ NULL,         '\0', 0,               NULL, 0,              NULL,                                    NULL },
 	};
@@ -605,6 +608,15 @@ bool ParseCommandLine(int argc, const char **argv)
 		case CLI_AUTOGAME:
 			wz_autogame = true;
 			break;
+
+		case CLI_PATHTRACE:
+			token = poptGetOptArg(poptCon);
+			if (token == NULL)
+			{
+				qFatal("Missing pathtrace filename?");
+			}
+			fpathSetTraceFile(token);
+			break;
 		};
 	}
 
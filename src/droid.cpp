@@ -307,6 +307,9 @@ int32_t droidDamage(DROID *psDroid, unsigned damage, WEAPON_CLASS weaponClass, W
 	return relativeDamage;
 }
 
+static ObjectPool droidPool(sizeof(DROID), "droid");
+DEFINE_OBJECT_POOL(DROID, droidPool)
+
 DROID::DROID(uint32_t id, unsigned player)
 	: BASE_OBJECT(OBJ_DROID, id, player)
 	, droidType(DROID_ANY)
@@ -707,7 +710,12 @@ void droidUpdate(DROID *psDroid)
 	{
 		visTilesUpdate(psDroid);
 		droidBodyUpgrade(psDroid);
-		psDroid->flags &= ~BASEFLAG_DIRTY;
+		psDroid->flags &= ~(BASEFLAG_DIRTY | BASEFLAG_DIRTY_VISION);
+	}
+	if (psDroid->flags & BASEFLAG_DIRTY_VISION)
+	{
+		visTilesUpdate(psDroid);
+		psDroid->flags &= ~BASEFLAG_DIRTY_VISION;
 	}
 
 	// Save old droid position, update time.
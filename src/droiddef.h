@@ -83,6 +83,7 @@ struct DROID : public BASE_OBJECT
 {
 	DROID(uint32_t id, unsigned player);
 	~DROID();
+	OBJECT_POOL_ALLOCATED;
 
 	/// UTF-8 name of the droid. This is generated from the droid template
 	///  WARNING: This *can* be changed by the game player after creation & can be translated, do NOT rely on this being the same for everyone!
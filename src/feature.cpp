@@ -302,12 +302,19 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 			}
 		}
 	}
+	if (!psStats->tileDraw && !FromSave)
+	{
+		visTerrainChanged(b.map.x, b.map.y, b.map.x + b.size.x, b.map.y + b.size.y);
+	}
 	psFeature->pos.z = map_TileHeight(b.map.x, b.map.y);//jps 18july97
 
 	return psFeature;
 }
 
 
+static ObjectPool featurePool(sizeof(FEATURE), "feature");
+DEFINE_OBJECT_POOL(FEATURE, featurePool)
+
 FEATURE::FEATURE(uint32_t id, FEATURE_STATS const *psStats)
 	: BASE_OBJECT(OBJ_FEATURE, id, PLAYER_FEATURE)  // Set the default player out of range to avoid targeting confusions
 	, psStats(psStats)
@@ -66,6 +66,7 @@ struct FEATURE : public BASE_OBJECT
 {
 	FEATURE(uint32_t id, FEATURE_STATS const *psStats);
 	~FEATURE();
+	OBJECT_POOL_ALLOCATED;
 
 	FEATURE_STATS const *psStats;
 };
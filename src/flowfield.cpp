@@ -0,0 +1,150 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Flow fields, for routing many droids to the same destination.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "flowfield.h"
+#include "pathcost.h"
+
+/// Direction offsets, straight moves first, so that routes prefer them when there is a choice.
+static const Vector2i flowDirOffset[8] =
+{
+	Vector2i(1, 0), Vector2i(0, 1), Vector2i(-1, 0), Vector2i(0, -1),
+	Vector2i(1, 1), Vector2i(-1, 1), Vector2i(-1, -1), Vector2i(1, -1),
+};
+
+void FlowField::clear()
+{
+	std::vector<uint32_t>().swap(dist);
+	std::vector<std::vector<uint32_t>>().swap(buckets);
+	map = nullptr;
+}
+
+bool FlowField::canMove(int x, int y, int dx, int dy) const
+{
+	if (isBlocked(x + dx, y + dy))
+	{
+		return false;
+	}
+	// We cannot cut corners.
+	return dx == 0 || dy == 0 || (!isBlocked(x + dx, y) && !isBlocked(x, y + dy));
+}
+
+void FlowField::build(TileBitmap const &map_, Vector2i dest_)
+{
+	map = &map_;
+	dest = dest_;
+	int width = map->getWidth();
+	dist.assign(width * map->getHeight(), UINT32_MAX);
+	if (isBlocked(dest.x, dest.y))
+	{
+		return;
+	}
+
+	// Dijkstra's algorithm with a bucket queue. Moves cost at most 198, so all unvisited tiles which have been reached are within 199
+	// buckets of the current one.
+	buckets.resize(199);
+	unsigned numQueued = 1;
+	dist[dest.x + dest.y * width] = 0;
+	buckets[0].push_back(dest.x + dest.y * width);
+	for (uint32_t d = 0; numQueued > 0; ++d)
+	{
+		std::vector<uint32_t> &bucket = buckets[d % buckets.size()];
+		for (unsigned i = 0; i < bucket.size(); ++i)  // bucket can't grow while we are using it, since moves cost more than 0.
+		{
+			uint32_t tile = bucket[i];
+			--numQueued;
+			if (dist[tile] != d)
+			{
+				continue;  // Already found a shorter route to this tile.
+			}
+			int x = tile % width, y = tile / width;
+			for (unsigned dir = 0; dir < ARRAY_SIZE(flowDirOffset); ++dir)
+			{
+				Vector2i offset = flowDirOffset[dir];
+				if (!canMove(x, y, offset.x, offset.y))
+				{
+					continue;
+				}
+				uint32_t newTile = tile + offset.x + offset.y * width;
+				uint32_t newDist = d + fpathMoveCost(offset.x, offset.y);
+				if (newDist < dist[newTile])
+				{
+					dist[newTile] = newDist;
+					buckets[newDist % buckets.size()].push_back(newTile);
+					++numQueued;
+				}
+			}
+		}
+		bucket.clear();
+	}
+}
+
+bool FlowField::route(Vector2i orig, std::vector<Vector2i> &path) const
+{
+	path.clear();
+	int width = map->getWidth();
+	if (orig.x < 0 || orig.y < 0 || orig.x >= width || orig.y >= map->getHeight() || dist[orig.x + orig.y * width] == UINT32_MAX)
+	{
+		return false;
+	}
+
+	// Walk downhill to dest, keeping the same direction for as long as it stays downhill, and only remembering where we turn.
+	path.push_back(orig);
+	Vector2i pos = orig;
+	int lastDir = -1;
+	while (pos != dest)
+	{
+		uint32_t d = dist[pos.x + pos.y * width];
+		int nextDir = -1;
+		for (int i = -1; i < (int)ARRAY_SIZE(flowDirOffset) && nextDir == -1; ++i)
+		{
+			int dir = i == -1 ? lastDir : i;
+			if (dir == -1)
+			{
+				continue;
+			}
+			Vector2i offset = flowDirOffset[dir];
+			if (!canMove(pos.x, pos.y, offset.x, offset.y))
+			{
+				continue;
+			}
+			uint32_t nextDist = dist[pos.x + offset.x + (pos.y + offset.y) * width];
+			if (nextDist != UINT32_MAX && nextDist + fpathMoveCost(offset.x, offset.y) == d)
+			{
+				nextDir = dir;
+			}
+		}
+		ASSERT_OR_RETURN(false, nextDir != -1, "Flow field has no way downhill from (%d, %d).", pos.x, pos.y);
+		if (nextDir != lastDir && lastDir != -1)
+		{
+			path.push_back(pos);
+		}
+		lastDir = nextDir;
+		pos += flowDirOffset[nextDir];
+	}
+	if (path.back() != dest)
+	{
+		path.push_back(dest);
+	}
+	return true;
+}
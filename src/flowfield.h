@@ -0,0 +1,84 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_FLOWFIELD_H__
+#define __INCLUDED_SRC_FLOWFIELD_H__
+
+#include "lib/framework/types.h"
+#include "lib/framework/vector.h"
+#include "tilebitmap.h"
+
+#include <vector>
+
+/** Distance from every reachable tile to one destination, for routing many droids to the same place.
+ *
+ *  Uses the same move costs as A* (140 horizontally/vertically, 198 diagonally, no cutting corners). Building the field costs
+ *  about as much as exploring the whole map once, after which a route from any tile costs only as much as its length.
+ *
+ *  The field and the routes only depend on the map and the end points, not on earlier fields.
+ *
+ *  @ingroup pathfinding
+ */
+class FlowField
+{
+public:
+	FlowField() : map(nullptr) {}
+
+	/// Finds the distance from every tile to dest on map, where set bits are blocking tiles. map must stay valid while the field is used.
+	void build(TileBitmap const &map, Vector2i dest);
+
+	/// Switches to a different map with the same contents as the one the field was built on.
+	void setMap(TileBitmap const &map_)
+	{
+		map = &map_;
+	}
+
+	/** Finds the route from orig to the destination, following the field.
+	 *
+	 *  @param path Set to the tiles where the route changes direction, from orig to the destination inclusive. Consecutive tiles
+	 *  are in a straight horizontal, vertical or diagonal line of open tiles.
+	 *  @return false if the destination can't be reached from orig.
+	 */
+	bool route(Vector2i orig, std::vector<Vector2i> &path) const;
+
+	/// Frees the memory used by the field.
+	void clear();
+
+	bool empty() const
+	{
+		return dist.empty();
+	}
+	Vector2i getDestination() const
+	{
+		return dest;
+	}
+
+private:
+	bool isBlocked(int x, int y) const
+	{
+		return x < 0 || y < 0 || x >= map->getWidth() || y >= map->getHeight() || map->get(x, y);
+	}
+	bool canMove(int x, int y, int dx, int dy) const;
+
+	TileBitmap const *map;
+	Vector2i dest;
+	std::vector<uint32_t> dist;                  ///< Distance from each tile to dest, or UINT32_MAX if unreachable.
+	std::vector<std::vector<uint32_t>> buckets;  ///< Scratch space for build(), tiles to visit by distance modulo the number of buckets.
+};
+
+#endif // __INCLUDED_SRC_FLOWFIELD_H__
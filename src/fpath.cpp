@@ -29,6 +29,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
+#include "lib/framework/physfs_ext.h"
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
@@ -42,8 +43,10 @@
 #include "multiplay.h"
 #include "astar.h"
 #include "action.h"
+#include "warzoneconfig.h"
 
 #include "fpath.h"
+#include "fpathlane.h"
 
 // If the path finding system is shutdown or not
 static volatile bool fpathQuit = false;
@@ -60,48 +63,95 @@ struct PATHRESULT
 };
 
 
+/** A queue of jobs which are run in order, one at a time, using the same cache.
+ *
+ *  Jobs are sorted into lanes by destination, so the result of a job only depends on the earlier jobs in the same lane, and not
+ *  on the number of threads or on which thread happens to run it.
+ */
+struct PathLane
+{
+	std::list<wz::packaged_task<PATHRESULT()>> jobs;
+	PathfindCache   *cache = nullptr;
+	bool            busy = false;     ///< A thread is currently running a job from this lane.
+};
+
 // threading stuff
-static WZ_THREAD        *fpathThread = NULL;
+static std::vector<WZ_THREAD *> fpathThreads;
 static WZ_MUTEX         *fpathMutex = NULL;
 static WZ_SEMAPHORE     *fpathSemaphore = NULL;
+static unsigned         fpathSleepingThreads = 0;  ///< Number of threads waiting on fpathSemaphore.
 using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+static PathLane         pathLanes[FPATH_LANES];
+static unsigned         pathNextLane = 0;          ///< Lane to look at first, so that all lanes get a turn.
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = NULL;
+static PATHRESULT fpathExecute(PATHJOB psJob, PathfindCache *cache);
 
-static PATHRESULT fpathExecute(PATHJOB psJob);
+static std::string      fpathTraceFilename;        ///< File to record path jobs to, or empty if not recording.
+static PHYSFS_file      *fpathTraceFile = NULL;
+static uint32_t         fpathTraceTime;            ///< gameTime of the last FPATH_TRACE_MAPS record.
+static std::vector<uint8_t> fpathTraceMaps;        ///< Maps as of the last FPATH_TRACE_MAPS record.
+static unsigned         fpathTraceGames;           ///< Number of traces started, so each game gets its own file.
+
+static void fpathTraceClose();
+
+
+/// Finds a lane with jobs waiting, which no other thread is working on. Call with fpathMutex locked.
+static PathLane *fpathTakeLane()
+{
+	for (unsigned n = 0; n < FPATH_LANES; ++n)
+	{
+		PathLane &lane = pathLanes[(pathNextLane + n) % FPATH_LANES];
+		if (!lane.busy && !lane.jobs.empty())
+		{
+			pathNextLane = (pathNextLane + n + 1) % FPATH_LANES;
+			return &lane;
+		}
+	}
+	return nullptr;
+}
 
+/// Whether all jobs have been run, and no thread is running one. Function is thread-safe.
+static bool fpathLanesIdle()
+{
+	bool idle = true;
 
-/** This runs in a separate thread */
+	wzMutexLock(fpathMutex);
+	for (PathLane const &lane : pathLanes)
+	{
+		idle = idle && !lane.busy && lane.jobs.empty();
+	}
+	wzMutexUnlock(fpathMutex);
+	return idle;
+}
+
+/** This runs in separate threads */
 static int fpathThreadFunc(void *)
 {
 	wzMutexLock(fpathMutex);
 
 	while (!fpathQuit)
 	{
-		if (pathJobs.empty())
+		PathLane *lane = fpathTakeLane();
+		if (lane == nullptr)
 		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			++fpathSleepingThreads;
 			wzMutexUnlock(fpathMutex);
 			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
 			continue;
 		}
 
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		// Take the first job from the lane, and keep other threads out of the lane until it's done.
+		packagedPathJob job = std::move(lane->jobs.front());
+		lane->jobs.pop_front();
+		lane->busy = true;
 
 		wzMutexUnlock(fpathMutex);
 		job();
 		wzMutexLock(fpathMutex);
 
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
+		lane->busy = false;
 	}
 	wzMutexUnlock(fpathMutex);
 	return 0;
@@ -114,14 +164,44 @@ bool fpathInitialise(void)
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	fpathTraceClose();  // The next job starts a new trace, for the map of the new game.
+
+	if (fpathThreads.empty())
 	{
 		fpathMutex = wzMutexCreate();
 		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, NULL);
-		wzThreadStart(fpathThread);
+		fpathSleepingThreads = 0;
+		for (PathLane &lane : pathLanes)
+		{
+			lane.cache = fpathCreateCache(FPATH_LANE_CACHE_SIZE);
+			lane.busy = false;
+		}
+
+		// Leave a core for the main thread. There is no point in having more threads than lanes.
+		int numThreads = war_GetWorkerThreads() > 0 ? war_GetWorkerThreads() : wzGetCpuCount() - 1;
+		numThreads = clip(numThreads, 1, FPATH_LANES);
+		debug(LOG_INFO, "Using %d pathfinding threads.", numThreads);
+		for (int i = 0; i < numThreads; ++i)
+		{
+			WZ_THREAD *thread = wzThreadCreate(fpathThreadFunc, NULL);
+			wzThreadStart(thread);
+			fpathThreads.push_back(thread);
+		}
 	}
+	else
+	{
+		// Routes depend on what is cached, so forget everything from the last game, once its jobs are done, so that all clients
+		// start from the same state.
+		while (!fpathLanesIdle())
+		{
+			wzYieldCurrentThread();
+		}
+		for (PathLane &lane : pathLanes)
+		{
+			fpathClearCache(lane.cache);
+		}
+	}
+	fpathHardTableReset();
 
 	return true;
 }
@@ -129,20 +209,29 @@ bool fpathInitialise(void)
 
 void fpathShutdown()
 {
-	// Signal the path finding thread to quit
+	// Signal the path finding threads to quit
 	fpathQuit = true;
-	wzSemaphorePost(fpathSemaphore);  // Wake up thread.
 
-	if (fpathThread)
+	if (!fpathThreads.empty())
 	{
-		wzThreadJoin(fpathThread);
-		fpathThread = NULL;
+		for (unsigned i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzSemaphorePost(fpathSemaphore);  // Wake up threads.
+		}
+		for (WZ_THREAD *thread : fpathThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		fpathThreads.clear();
+		for (PathLane &lane : pathLanes)
+		{
+			fpathDestroyCache(lane.cache);
+			lane.cache = nullptr;
+		}
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = NULL;
 		wzSemaphoreDestroy(fpathSemaphore);
 		fpathSemaphore = NULL;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = NULL;
 	}
 	fpathHardTableReset();
 }
@@ -158,65 +247,6 @@ void fpathUpdate(void)
 }
 
 
-bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
-                               PROPULSION_TYPE propulsion2, int player2, FPATH_MOVETYPE moveType2)
-{
-	int domain1, domain2;
-	switch (propulsion1)
-	{
-	default:                        domain1 = 0; break;  // Land
-	case PROPULSION_TYPE_LIFT:      domain1 = 1; break;  // Air
-	case PROPULSION_TYPE_PROPELLOR: domain1 = 2; break;  // Water
-	case PROPULSION_TYPE_HOVER:     domain1 = 3; break;  // Land and water
-	}
-	switch (propulsion2)
-	{
-	default:                        domain2 = 0; break;  // Land
-	case PROPULSION_TYPE_LIFT:      domain2 = 1; break;  // Air
-	case PROPULSION_TYPE_PROPELLOR: domain2 = 2; break;  // Water
-	case PROPULSION_TYPE_HOVER:     domain2 = 3; break;  // Land and water
-	}
-
-	if (domain1 != domain2)
-	{
-		return false;
-	}
-
-	if (domain1 == 1)
-	{
-		return true;  // Air units ignore move type and player.
-	}
-
-	if (moveType1 != moveType2 || player1 != player2)
-	{
-		return false;
-	}
-
-	return true;
-}
-
-static uint8_t prop2bits(PROPULSION_TYPE propulsion)
-{
-	uint8_t bits;
-
-	switch (propulsion)
-	{
-	case PROPULSION_TYPE_LIFT:
-		bits = AIR_BLOCKED;
-		break;
-	case PROPULSION_TYPE_HOVER:
-		bits = FEATURE_BLOCKED;
-		break;
-	case PROPULSION_TYPE_PROPELLOR:
-		bits = FEATURE_BLOCKED | LAND_BLOCKED;
-		break;
-	default:
-		bits = FEATURE_BLOCKED | WATER_BLOCKED;
-		break;
-	}
-	return bits;
-}
-
 // Check if the map tile at a location blocks a droid
 bool fpathBaseBlockingTile(SDWORD x, SDWORD y, PROPULSION_TYPE propulsion, int mapIndex, FPATH_MOVETYPE moveType)
 {
@@ -234,15 +264,8 @@ bool fpathBaseBlockingTile(SDWORD x, SDWORD y, PROPULSION_TYPE propulsion, int m
 	}
 	unsigned aux = auxTile(x, y, mapIndex);
 
-	int auxMask = 0;
-	switch (moveType)
-	{
-	case FMT_MOVE:   auxMask = AUXBITS_NONPASSABLE; break;   // do not wish to shoot our way through enemy buildings, but want to go through friendly gates (without shooting them)
-	case FMT_ATTACK: auxMask = AUXBITS_OUR_BUILDING; break;  // move blocked by friendly building, assuming we do not want to shoot it up en route
-	case FMT_BLOCK:  auxMask = AUXBITS_BLOCKING; break;      // Do not wish to tunnel through closed gates or buildings.
-	}
-
-	unsigned unitbits = prop2bits(propulsion);  // TODO - cache prop2bits to psDroid, and pass in instead of propulsion type
+	int auxMask = fpathMoveTypeBlockingBits(moveType);
+	unsigned unitbits = fpathPropulsionBlockingBits(propulsion);  // TODO - cache to psDroid, and pass in instead of propulsion type
 	if ((unitbits & FEATURE_BLOCKED) != 0 && (aux & auxMask) != 0)
 	{
 		return true;	// move blocked by building, and we cannot or do not want to shoot our way through anything
@@ -317,6 +340,124 @@ void fpathRemoveDroidData(int id)
 	pathResults.erase(id);
 }
 
+void fpathSetTraceFile(const char *filename)
+{
+	fpathTraceClose();
+	fpathTraceFilename = filename != NULL ? filename : "";
+	fpathTraceGames = 0;
+}
+
+static uint8_t const *fpathTraceMap(unsigned index)
+{
+	return index < AUX_MAX ? psBlockMap[index] : psAuxMap[index - AUX_MAX];
+}
+
+static void fpathTraceClose()
+{
+	if (fpathTraceFile != NULL)
+	{
+		PHYSFS_close(fpathTraceFile);
+		fpathTraceFile = NULL;
+	}
+	std::vector<uint8_t>().swap(fpathTraceMaps);
+}
+
+/// Writes the tiles which changed since the last FPATH_TRACE_MAPS record.
+static void fpathTraceWriteMaps()
+{
+	unsigned humanPlayers = 0;
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		humanPlayers |= isHumanPlayer(player) << player;
+	}
+	uint32_t header[] = {FPATH_TRACE_MAPS, gameTime, (uint32_t)scrollMinX, (uint32_t)scrollMinY, (uint32_t)scrollMaxX, (uint32_t)scrollMaxY, humanPlayers};
+	for (uint32_t value : header)
+	{
+		PHYSFS_writeULE32(fpathTraceFile, value);
+	}
+
+	unsigned tiles = mapWidth * mapHeight;
+	std::vector<uint32_t> changed;
+	for (unsigned index = 0; index < FPATH_TRACE_NUM_MAPS; ++index)
+	{
+		uint8_t const *map = fpathTraceMap(index);
+		uint8_t *copy = &fpathTraceMaps[index * tiles];
+		changed.clear();
+		for (unsigned tile = 0; tile < tiles; ++tile)
+		{
+			if (copy[tile] != map[tile])
+			{
+				copy[tile] = map[tile];
+				changed.push_back(tile);
+			}
+		}
+		if (changed.empty())
+		{
+			continue;
+		}
+		PHYSFS_writeULE32(fpathTraceFile, index);
+		PHYSFS_writeULE32(fpathTraceFile, changed.size());
+		for (uint32_t tile : changed)
+		{
+			PHYSFS_writeULE32(fpathTraceFile, tile);
+			PHYSFS_writeULE32(fpathTraceFile, map[tile]);
+		}
+	}
+	PHYSFS_writeULE32(fpathTraceFile, 0xFFFFFFFF);
+	fpathTraceTime = gameTime;
+}
+
+/// Starts a trace for the current map. Returns false if the file couldn't be opened.
+static bool fpathTraceOpen()
+{
+	std::string filename = astringf("%s.%u", fpathTraceFilename.c_str(), ++fpathTraceGames);
+	fpathTraceFile = PHYSFS_openWrite(filename.c_str());
+	if (fpathTraceFile == NULL)
+	{
+		debug(LOG_ERROR, "Could not open \"%s\" for recording path jobs: %s", filename.c_str(), PHYSFS_getLastError());
+		fpathTraceFilename.clear();
+		return false;
+	}
+
+	// Start with only the terrain, which tests/pathbench gets from the map file.
+	unsigned tiles = mapWidth * mapHeight;
+	fpathTraceMaps.assign(FPATH_TRACE_NUM_MAPS * tiles, 0);
+	for (unsigned tile = 0; tile < tiles; ++tile)
+	{
+		fpathTraceMaps[tile] = mapTerrainBlocking(&psMapTiles[tile]);
+	}
+	uint32_t header[] = {FPATH_TRACE_MAGIC, FPATH_TRACE_VERSION, (uint32_t)mapWidth, (uint32_t)mapHeight, crcSum(0, &fpathTraceMaps[0], tiles)};
+	for (uint32_t value : header)
+	{
+		PHYSFS_writeULE32(fpathTraceFile, value);
+	}
+	debug(LOG_INFO, "Recording path jobs to \"%s\".", filename.c_str());
+
+	fpathTraceWriteMaps();
+	return true;
+}
+
+/// Records a job, with any changes to the maps since the last job.
+static void fpathTraceJob(PATHJOB const &job)
+{
+	if (fpathTraceFile == NULL && !fpathTraceOpen())
+	{
+		return;
+	}
+	if (fpathTraceTime != gameTime)
+	{
+		fpathTraceWriteMaps();
+	}
+	uint32_t record[] = {FPATH_TRACE_JOB, job.droidID, (uint32_t)job.origX, (uint32_t)job.origY, (uint32_t)job.destX, (uint32_t)job.destY,
+	                     (uint32_t)job.dstStructure.map.x, (uint32_t)job.dstStructure.map.y, (uint32_t)job.dstStructure.size.x, (uint32_t)job.dstStructure.size.y,
+	                     job.propulsion, job.droidType, job.moveType, (uint32_t)job.owner, job.acceptNearest
+	                    };
+	for (uint32_t value : record)
+	{
+		PHYSFS_writeULE32(fpathTraceFile, value);
+	}
+}
+
 static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, int startY, int tX, int tY, PROPULSION_TYPE propulsionType,
                                DROID_TYPE droidType, FPATH_MOVETYPE moveType, int owner, bool acceptNearest, StructureBounds const &dstStructure)
 {
@@ -390,6 +531,10 @@ queuePathfinding:
 	job.owner = owner;
 	job.acceptNearest = acceptNearest;
 	job.deleted = false;
+	if (!fpathTraceFilename.empty())
+	{
+		fpathTraceJob(job);
+	}
 	fpathSetBlockingMap(&job);
 
 	debug(LOG_NEVER, "starting new job for droid %d 0x%x", id, id);
@@ -397,21 +542,29 @@ queuePathfinding:
 	// job or result for each droid in the system at any time.
 	fpathRemoveDroidData(id);
 
-	packagedPathJob task([job]() { return fpathExecute(job); });
+	unsigned laneIndex = fpathJobLane(job);
+	PathLane &lane = pathLanes[laneIndex];
+	// The lane is captured rather than passed by the thread, since which thread runs the job must not matter.
+	packagedPathJob task([job, &lane]() { return fpathExecute(job, lane.cache); });
 	pathResults[id] = std::move(task.get_future());
 
-	// Add to end of list
+	// Add to end of lane
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
+	size_t earlierJobs = lane.jobs.size();
+	lane.jobs.push_back(std::move(task));
+	bool wakeThread = fpathSleepingThreads > 0;
+	if (wakeThread)
+	{
+		--fpathSleepingThreads;
+	}
 	wzMutexUnlock(fpathMutex);
 
-	if (isFirstJob)
+	if (wakeThread)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		wzSemaphorePost(fpathSemaphore);  // Wake up a processing thread.
 	}
 
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	objTrace(id, "Queued up a path-finding request to (%d, %d) in lane %u, %d items earlier in lane", tX, tY, laneIndex, (int)earlierJobs);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -461,8 +614,8 @@ FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD tX, SDWORD tY, FPATH_MOVETYP
 	                  psDroid->droidType, moveType, psDroid->player, acceptNearest, dstStructure);
 }
 
-// Run only from path thread
-PATHRESULT fpathExecute(PATHJOB job)
+// Run only from path threads
+PATHRESULT fpathExecute(PATHJOB job, PathfindCache *cache)
 {
 	PATHRESULT result;
 	result.droidID = job.droidID;
@@ -470,7 +623,7 @@ PATHRESULT fpathExecute(PATHJOB job)
 	result.retval = FPR_FAILED;
 	result.originalDest = Vector2i(job.destX, job.destY);
 
-	ASR_RETVAL retval = fpathAStarRoute(&result.sMove, &job);
+	ASR_RETVAL retval = fpathAStarRoute(cache, &result.sMove, &job);
 
 	ASSERT(retval != ASR_OK || result.sMove.asPath, "Ok result but no path in result");
 	ASSERT(retval == ASR_FAILED || result.sMove.numPoints > 0, "Ok result but no length of path in result");
@@ -516,7 +669,10 @@ static int fpathJobQueueLength(void)
 	int count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	for (PathLane const &lane : pathLanes)
+	{
+		count += lane.jobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	}
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -550,10 +706,10 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength;
 
 	/* Check initial state */
-	assert(fpathThread != NULL);
+	assert(!fpathThreads.empty());
 	assert(fpathMutex != NULL);
 	assert(fpathSemaphore != NULL);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -621,7 +777,7 @@ void fpathTest(int x, int y, int x2, int y2)
 	{
 		fpathRemoveDroidData(i);
 	}
-	//assert(pathJobs.empty()); // can now be marked .deleted as well
+	//assert(fpathJobQueueLength() == 0); // can now be marked .deleted as well
 	assert(pathResults.empty());
 	(void)r;  // Squelch unused-but-set warning.
 }
@@ -100,6 +100,10 @@ bool fpathBlockingTile(SDWORD x, SDWORD y, PROPULSION_TYPE propulsion);
 bool fpathDroidBlockingTile(DROID *psDroid, int x, int y, FPATH_MOVETYPE moveType);
 bool fpathBaseBlockingTile(SDWORD x, SDWORD y, PROPULSION_TYPE propulsion, int player, FPATH_MOVETYPE moveType);
 
+/// The psBlockMap bits which block the propulsion type, and the psAuxMap bits which block the move type, as used by fpathBaseBlockingTile.
+uint8_t fpathPropulsionBlockingBits(PROPULSION_TYPE propulsion);
+uint8_t fpathMoveTypeBlockingBits(FPATH_MOVETYPE moveType);
+
 static inline bool fpathBlockingTile(Vector2i tile, PROPULSION_TYPE propulsion)
 {
 	return fpathBlockingTile(tile.x, tile.y, propulsion);
@@ -124,6 +128,32 @@ bool fpathCheck(Position orig, Position dest, PROPULSION_TYPE propulsion);
 /** Unit testing. */
 void fpathTest(int x, int y, int x2, int y2);
 
+/** Path job traces, for replaying the jobs of a real game in tests/pathbench.
+ *
+ *  All values are little-endian 32-bit unsigned integers. The trace starts with FPATH_TRACE_MAGIC, FPATH_TRACE_VERSION, the map
+ *  width and height, and the crcSum of the terrain blocking bits of each tile, as given by mapTerrainBlocking. Then come records,
+ *  each starting with its FPATH_TRACE_RECORD type.
+ *
+ *  The maps in the trace are psBlockMap[0 ... AUX_MAX - 1] followed by psAuxMap[0 ... MAX_PLAYERS + AUX_MAX - 1]. At the start,
+ *  the first map has the terrain blocking bits, and all other maps are 0.
+ */
+#define FPATH_TRACE_MAGIC	0x54505A57	///< "WZPT"
+#define FPATH_TRACE_VERSION	1
+
+enum FPATH_TRACE_RECORD
+{
+	/// gameTime, scrollMinX, scrollMinY, scrollMaxX, scrollMaxY, bit mask of human players, then for each changed map, the map
+	/// index, the number of changed tiles, and the tile index and new value of each changed tile, and finally 0xFFFFFFFF.
+	FPATH_TRACE_MAPS,
+	/// droidID, origX, origY, destX, destY, dstStructure.map.x, .map.y, .size.x, .size.y, propulsion, droidType, moveType, owner,
+	/// acceptNearest. Written after any FPATH_TRACE_MAPS record needed to get the blocking map of the job.
+	FPATH_TRACE_JOB,
+};
+
+/// Records the path jobs of each game to a file in the write directory, or stops recording if filename is NULL. The games are
+/// numbered from 1, and each is written to filename.1, filename.2 and so on.
+void fpathSetTraceFile(const char *filename);
+
 /** @} */
 
 #endif // __INCLUDED_SRC_FPATH_H__
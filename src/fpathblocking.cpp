@@ -0,0 +1,98 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Which map bits block which droids. Declared in fpath.h, and kept apart from fpath.cpp so that tests/pathbench can use the same
+ *  rules as the game.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "map.h"
+#include "fpath.h"
+
+
+bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
+                               PROPULSION_TYPE propulsion2, int player2, FPATH_MOVETYPE moveType2)
+{
+	int domain1, domain2;
+	switch (propulsion1)
+	{
+	default:                        domain1 = 0; break;  // Land
+	case PROPULSION_TYPE_LIFT:      domain1 = 1; break;  // Air
+	case PROPULSION_TYPE_PROPELLOR: domain1 = 2; break;  // Water
+	case PROPULSION_TYPE_HOVER:     domain1 = 3; break;  // Land and water
+	}
+	switch (propulsion2)
+	{
+	default:                        domain2 = 0; break;  // Land
+	case PROPULSION_TYPE_LIFT:      domain2 = 1; break;  // Air
+	case PROPULSION_TYPE_PROPELLOR: domain2 = 2; break;  // Water
+	case PROPULSION_TYPE_HOVER:     domain2 = 3; break;  // Land and water
+	}
+
+	if (domain1 != domain2)
+	{
+		return false;
+	}
+
+	if (domain1 == 1)
+	{
+		return true;  // Air units ignore move type and player.
+	}
+
+	if (moveType1 != moveType2 || player1 != player2)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+uint8_t fpathPropulsionBlockingBits(PROPULSION_TYPE propulsion)
+{
+	uint8_t bits;
+
+	switch (propulsion)
+	{
+	case PROPULSION_TYPE_LIFT:
+		bits = AIR_BLOCKED;
+		break;
+	case PROPULSION_TYPE_HOVER:
+		bits = FEATURE_BLOCKED;
+		break;
+	case PROPULSION_TYPE_PROPELLOR:
+		bits = FEATURE_BLOCKED | LAND_BLOCKED;
+		break;
+	default:
+		bits = FEATURE_BLOCKED | WATER_BLOCKED;
+		break;
+	}
+	return bits;
+}
+
+uint8_t fpathMoveTypeBlockingBits(FPATH_MOVETYPE moveType)
+{
+	switch (moveType)
+	{
+	case FMT_MOVE:   return AUXBITS_NONPASSABLE;   // do not wish to shoot our way through enemy buildings, but want to go through friendly gates (without shooting them)
+	case FMT_ATTACK: return AUXBITS_OUR_BUILDING;  // move blocked by friendly building, assuming we do not want to shoot it up en route
+	case FMT_BLOCK:  return AUXBITS_BLOCKING;      // Do not wish to tunnel through closed gates or buildings.
+	}
+	return 0;
+}
@@ -0,0 +1,47 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  How path jobs are split between the lanes of the pathfinding threads. Used by fpath.cpp, and by tests/pathbench to replay
+ *  traces the same way.
+ */
+
+#ifndef __INCLUDED_SRC_FPATHLANE_H__
+#define __INCLUDED_SRC_FPATHLANE_H__
+
+#include "map.h"
+#include "astar.h"
+
+/// Number of independent job queues. Must be the same on all clients, since it affects which jobs share a cache.
+#define FPATH_LANES 8
+
+/// Contexts kept by the cache of each lane, splitting PATHFIND_CACHE_SIZE between the lanes. Must be the same on all clients too.
+#define FPATH_LANE_CACHE_SIZE (PATHFIND_CACHE_SIZE / FPATH_LANES)
+
+/// Number of maps in a path job trace, see FPATH_TRACE_RECORD.
+#define FPATH_TRACE_NUM_MAPS (AUX_MAX + MAX_PLAYERS + AUX_MAX)
+
+/// Which lane a job goes in. Jobs which might share cached data must go in the same lane.
+static inline unsigned fpathJobLane(PATHJOB const &job)
+{
+	// Cached contexts are only reused for the same destination tile.
+	uint32_t tile = map_coord(job.destX) + map_coord(job.destY) * mapWidth;
+	return (tile * 2654435761u >> 16) % FPATH_LANES;
+}
+
+#endif // __INCLUDED_SRC_FPATHLANE_H__
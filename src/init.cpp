@@ -96,6 +96,7 @@
 #include "ingameop.h"
 #include "qtscript.h"
 #include "template.h"
+#include "workerpool.h"
 
 static void initMiscVars();
 
@@ -769,6 +770,7 @@ void systemShutdown(void)
 	levShutDown();
 	widgShutDown();
 	fpathShutdown();
+	workerPoolShutdown();
 	mapShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
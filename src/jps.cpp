@@ -0,0 +1,235 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Jump Point Search.
+ *  See "Online Graph Pruning for Pathfinding on Grid Maps" (Harabor, Grastien) for the general idea.
+ *
+ *  Since corners can't be cut, a diagonal move needs both tiles beside it to be open. That changes which neighbours are forced:
+ *  when moving horizontally, the tiles above and below are always worth looking at, but are only jump points if they could not
+ *  have been reached diagonally from the previous tile.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "jps.h"
+#include "pathcost.h"
+
+#include <algorithm>
+
+static inline unsigned jpsEstimate(Vector2i a, Vector2i b)
+{
+	return fpathMoveCost(a.x - b.x, a.y - b.y);
+}
+
+void JumpPointSearch::clear()
+{
+	std::vector<Tile>().swap(tiles);
+	std::vector<Node>().swap(nodes);
+	iteration = 0;
+}
+
+bool JumpPointSearch::jumpStraight(int x, int y, int dx, int dy, Vector2i &jumpPoint) const
+{
+	while (true)
+	{
+		x += dx;
+		y += dy;
+		if (isBlocked(x, y))
+		{
+			return false;
+		}
+		if (x == dest.x && y == dest.y)
+		{
+			break;
+		}
+		// A tile beside us is a forced neighbour, if it couldn't be reached diagonally from the previous tile.
+		if (dx != 0 && ((!isBlocked(x, y - 1) && isBlocked(x - dx, y - 1)) || (!isBlocked(x, y + 1) && isBlocked(x - dx, y + 1))))
+		{
+			break;
+		}
+		if (dy != 0 && ((!isBlocked(x - 1, y) && isBlocked(x - 1, y - dy)) || (!isBlocked(x + 1, y) && isBlocked(x + 1, y - dy))))
+		{
+			break;
+		}
+	}
+	jumpPoint = Vector2i(x, y);
+	return true;
+}
+
+bool JumpPointSearch::jump(int x, int y, int dx, int dy, Vector2i &jumpPoint) const
+{
+	if (dx == 0 || dy == 0)
+	{
+		return jumpStraight(x, y, dx, dy, jumpPoint);
+	}
+
+	Vector2i straightPoint;
+	while (true)
+	{
+		// We cannot cut corners.
+		if (isBlocked(x + dx, y) || isBlocked(x, y + dy))
+		{
+			return false;
+		}
+		x += dx;
+		y += dy;
+		if (isBlocked(x, y))
+		{
+			return false;
+		}
+		if ((x == dest.x && y == dest.y) || jumpStraight(x, y, dx, 0, straightPoint) || jumpStraight(x, y, 0, dy, straightPoint))
+		{
+			break;
+		}
+	}
+	jumpPoint = Vector2i(x, y);
+	return true;
+}
+
+void JumpPointSearch::addNode(Vector2i pos, Vector2i parent, unsigned dist)
+{
+	Tile &tile = tiles[pos.x + pos.y * map->getWidth()];
+	if (tile.iteration == iteration && (tile.closed || tile.dist <= dist))
+	{
+		return;  // Already have a route here at least as short.
+	}
+	tile.iteration = iteration;
+	tile.closed = false;
+	tile.parentX = parent.x;
+	tile.parentY = parent.y;
+	tile.dist = dist;
+
+	Node node;
+	node.x = pos.x;
+	node.y = pos.y;
+	node.dist = dist;
+	node.est = dist + jpsEstimate(pos, dest);
+	nodes.push_back(node);
+	std::push_heap(nodes.begin(), nodes.end());
+}
+
+bool JumpPointSearch::route(TileBitmap const &map_, Vector2i orig, Vector2i dest_, std::vector<Vector2i> &path)
+{
+	map = &map_;
+	dest = dest_;
+	nodesExpanded = 0;
+	path.clear();
+	if (isBlocked(orig.x, orig.y) || isBlocked(dest.x, dest.y))
+	{
+		return false;
+	}
+
+	// Make the iteration not match any value of iteration in tiles.
+	if (++iteration == 0xFFFF)
+	{
+		tiles.clear();
+		iteration = 0;
+	}
+	tiles.resize(map->getWidth() * map->getHeight());
+	nodes.clear();
+
+	addNode(orig, orig, 0);
+	bool found = false;
+	while (!nodes.empty())
+	{
+		std::pop_heap(nodes.begin(), nodes.end());
+		Node node = nodes.back();
+		nodes.pop_back();
+
+		Tile &tile = tiles[node.x + node.y * map->getWidth()];
+		if (tile.closed || tile.dist != node.dist)
+		{
+			continue;  // Already been here.
+		}
+		tile.closed = true;
+		++nodesExpanded;
+
+		Vector2i pos(node.x, node.y);
+		if (pos == dest)
+		{
+			found = true;
+			break;
+		}
+
+		// Directions worth looking in, given the direction we came from.
+		Vector2i dirs[8];
+		unsigned numDirs = 0;
+		Vector2i from(tile.parentX, tile.parentY);
+		int dx = clip(pos.x - from.x, -1, 1), dy = clip(pos.y - from.y, -1, 1);
+		if (dx == 0 && dy == 0)
+		{
+			// Start tile, look everywhere.
+			for (int y = -1; y <= 1; ++y)
+			{
+				for (int x = -1; x <= 1; ++x)
+				{
+					if (x != 0 || y != 0)
+					{
+						dirs[numDirs++] = Vector2i(x, y);
+					}
+				}
+			}
+		}
+		else if (dx != 0 && dy != 0)
+		{
+			dirs[numDirs++] = Vector2i(dx, dy);
+			dirs[numDirs++] = Vector2i(dx, 0);
+			dirs[numDirs++] = Vector2i(0, dy);
+		}
+		else
+		{
+			// Moving straight, also look to both sides, and diagonally forwards to both sides.
+			Vector2i side(dy, dx);
+			dirs[numDirs++] = Vector2i(dx, dy);
+			dirs[numDirs++] = Vector2i(dx, dy) + side;
+			dirs[numDirs++] = Vector2i(dx, dy) - side;
+			dirs[numDirs++] = side;
+			dirs[numDirs++] = -side;
+		}
+
+		for (unsigned i = 0; i < numDirs; ++i)
+		{
+			Vector2i jumpPoint;
+			if (jump(pos.x, pos.y, dirs[i].x, dirs[i].y, jumpPoint))
+			{
+				addNode(jumpPoint, pos, node.dist + jpsEstimate(pos, jumpPoint));
+			}
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	// Get the route, in reverse order.
+	for (Vector2i p = dest; true;)
+	{
+		path.push_back(p);
+		Tile const &tile = tiles[p.x + p.y * map->getWidth()];
+		Vector2i parent(tile.parentX, tile.parentY);
+		if (parent == p)
+		{
+			break;
+		}
+		p = parent;
+	}
+	std::reverse(path.begin(), path.end());
+	return true;
+}
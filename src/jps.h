@@ -0,0 +1,106 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_JPS_H__
+#define __INCLUDED_SRC_JPS_H__
+
+#include "lib/framework/types.h"
+#include "lib/framework/vector.h"
+#include "tilebitmap.h"
+
+#include <vector>
+
+/** Jump Point Search, for finding routes on maps where all open tiles cost the same to cross.
+ *
+ *  Finds the same length of route as A* with the same move costs (140 horizontally/vertically, 198 diagonally, no cutting
+ *  corners), but only puts the tiles where the route may turn on the open list. The result only depends on the map and the end
+ *  points, not on earlier searches.
+ *
+ *  An instance keeps its memory between searches, and must only be used by one thread at a time.
+ *
+ *  @ingroup pathfinding
+ */
+class JumpPointSearch
+{
+public:
+	JumpPointSearch() : iteration(0), map(nullptr), nodesExpanded(0) {}
+
+	/** Finds a route from orig to dest on map, where set bits are blocking tiles.
+	 *
+	 *  @param path Set to the tiles where the route changes direction, from orig to dest inclusive. Consecutive tiles are in a
+	 *  straight horizontal, vertical or diagonal line of open tiles.
+	 *  @return false if dest can't be reached from orig.
+	 */
+	bool route(TileBitmap const &map, Vector2i orig, Vector2i dest, std::vector<Vector2i> &path);
+
+	/// Frees the memory used by the search.
+	void clear();
+
+private:
+	struct Node
+	{
+		bool operator <(Node const &z) const
+		{
+			// Same ordering as PathNode, for a well defined result: descending est, then ascending dist, then by position.
+			if (est != z.est)
+			{
+				return est > z.est;
+			}
+			if (dist != z.dist)
+			{
+				return dist < z.dist;
+			}
+			if (x != z.x)
+			{
+				return x < z.x;
+			}
+			return y < z.y;
+		}
+
+		int16_t  x, y;
+		unsigned dist, est;
+	};
+	struct Tile
+	{
+		Tile() : iteration(0xFFFF), closed(false), parentX(0), parentY(0), dist(0) {}
+
+		uint16_t iteration;
+		bool     closed;
+		int16_t  parentX, parentY;     ///< Previous jump point on the route to this tile.
+		unsigned dist;
+	};
+
+	bool isBlocked(int x, int y) const
+	{
+		return x < 0 || y < 0 || x >= map->getWidth() || y >= map->getHeight() || map->get(x, y);
+	}
+	bool jump(int x, int y, int dx, int dy, Vector2i &jumpPoint) const;
+	bool jumpStraight(int x, int y, int dx, int dy, Vector2i &jumpPoint) const;
+	void addNode(Vector2i pos, Vector2i parent, unsigned dist);
+
+	std::vector<Tile> tiles;
+	std::vector<Node> nodes;
+	uint16_t iteration;
+	TileBitmap const *map;
+	Vector2i dest;
+
+public:
+	unsigned nodesExpanded;  ///< Number of nodes taken from the open list by the last search, for benchmarks.
+};
+
+#endif // __INCLUDED_SRC_JPS_H__
@@ -638,6 +638,12 @@ void kf_ShowNumObjects(void)
 	sasprintf((char **)&cmsg, _("(Player %u) is using a cheat :Num Droids: %d  Num Structures: %d  Num Features: %d"),
 	          selectedPlayer, droids, structures, features);
 	sendTextMessage(cmsg, true);
+
+	for (ObjectPoolStats const &stats : ObjectPool::allStats())
+	{
+		sasprintf((char **)&cmsg, "Pool %s: %u live, %u free, %u high water", stats.name, (unsigned)stats.live, (unsigned)stats.free, (unsigned)stats.highWater);
+		addConsoleMessage(cmsg, DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+	}
 }
 
 // --------------------------------------------------------------------------
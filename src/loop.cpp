@@ -43,6 +43,7 @@
 #include "lib/netplay/netplay.h"
 
 #include "loop.h"
+#include "ai.h"
 #include "objects.h"
 #include "display.h"
 #include "map.h"
@@ -604,6 +605,9 @@ static void gameStateUpdate()
 
 	fireWaitingCallbacks(); //Now is the good time to fire waiting callbacks (since interpreter is off now)
 
+	// Search for the objects near droids on the worker threads, the droids then choose targets from them while being updated.
+	aiPrepareTargetSearches();
+
 	for (unsigned i = 0; i < MAX_PLAYERS; i++)
 	{
 		//update the current power available for a player
@@ -641,6 +645,8 @@ static void gameStateUpdate()
 		}
 	}
 
+	aiForgetTargetSearches();
+
 	missionTimerUpdate();
 
 	proj_UpdateAll();
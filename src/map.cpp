@@ -50,21 +50,44 @@
 #include "levels.h"
 #include "scriptfuncs.h"
 #include "lib/framework/wzapp.h"
+#include "tilebitmap.h"
+#include "workerpool.h"
+
+#include <unordered_map>
 
 #define GAME_TICKS_FOR_DANGER (GAME_TICKS_PER_SEC * 2)
 
-static WZ_THREAD *dangerThread = NULL;
-static WZ_SEMAPHORE *dangerSemaphore = NULL;
-static WZ_SEMAPHORE *dangerDoneSemaphore = NULL;
-struct floodtile
+/// Danger map calculation for one player. Filled in by the main thread, and then run on the worker threads.
+struct DangerJob
 {
-	uint8_t x;
-	uint8_t y;
+	int                   player;
+	Vector2i              start;           ///< Tile to flood fill from.
+	TileBitmap            nonpassable;     ///< Tiles with a building in the way, copied from the aux map.
+	TileBitmap            featureBlocked;  ///< Tiles with a feature in the way, copied from the block map.
+	TileBitmap            reached;         ///< Tiles found by the flood fill.
+	TileBitmap            safe;            ///< Tiles out of danger, either searched from or not to be searched from.
+	std::vector<Vector2i> stack;           ///< Flood fill scratch.
+	std::vector<uint8_t>  auxBits;         ///< Result, the AUXBITS_DANGER, AUXBITS_THREAT and AUXBITS_AATHREAT bits of each tile.
 };
-static struct floodtile *floodbucket = NULL;
-static int bucketcounter;
+
+/// Tiles an object with weapons was counted as a threat on, when threatUpdate last looked at it.
+struct ThreatSource
+{
+	std::vector<TILEPOS> tiles;
+	PlayerMask           players = 0;     ///< Players the object is a threat to.
+	uint8_t              mode = 0;        ///< SHOOT_ON_GROUND and/or SHOOT_IN_AIR.
+	uint32_t             lastSeen = 0;    ///< Value of threatUpdateCount when last seen.
+};
+
+enum {THREAT_GROUND, THREAT_AIR, THREAT_TYPES};
+
+static DangerJob dangerJobs[MAX_PLAYERS];
+static std::vector<uint16_t> threatCount[MAX_PLAYERS][THREAT_TYPES];  ///< Number of threat sources which can shoot at each tile.
+static std::unordered_map<uint32_t, ThreatSource> threatSources;      ///< Indexed by object id.
+static uint32_t threatUpdateCount = 0;
+
+static int dangerJobsDone = 0;  ///< Number of jobs run, whose results haven't been applied yet.
 static UDWORD lastDangerUpdate = 0;
-static int lastDangerPlayer = -1;
 
 //scroll min and max values
 SDWORD		scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
@@ -899,18 +922,7 @@ bool mapLoad(char *filename, bool preview)
 			{
 				auxSetBlocking(x, y, AUXBITS_ALL);	// block everything
 			}
-			if (terrainType(psTile) == TER_WATER)
-			{
-				auxSetBlocking(x, y, WATER_BLOCKED);
-			}
-			else
-			{
-				auxSetBlocking(x, y, LAND_BLOCKED);
-			}
-			if (terrainType(psTile) == TER_CLIFFFACE)
-			{
-				auxSetBlocking(x, y, FEATURE_BLOCKED);
-			}
+			auxSetBlocking(x, y, mapTerrainBlocking(psTile));
 		}
 	}
 
@@ -1018,18 +1030,8 @@ bool mapShutdown(void)
 {
 	int x;
 
-	if (dangerThread)
-	{
-		wzSemaphoreWait(dangerDoneSemaphore);
-		lastDangerPlayer = -1;
-		wzSemaphorePost(dangerSemaphore);
-		wzThreadJoin(dangerThread);
-		wzSemaphoreDestroy(dangerSemaphore);
-		wzSemaphoreDestroy(dangerDoneSemaphore);
-		dangerThread = NULL;
-		dangerSemaphore = NULL;
-		dangerDoneSemaphore = NULL;
-	}
+	dangerJobsDone = 0;
+	threatSources.clear();
 
 	free(psMapTiles);
 	delete[] mapDecals;
@@ -1041,7 +1043,6 @@ bool mapShutdown(void)
 	free(psBlockMap[AUX_ASTARMAP]);
 	psBlockMap[AUX_ASTARMAP] = NULL;
 	free(psBlockMap[AUX_DANGERMAP]);
-	free(floodbucket);
 	psBlockMap[AUX_DANGERMAP] = NULL;
 	for (x = 0; x < MAX_PLAYERS + AUX_MAX; x++)
 	{
@@ -1050,7 +1051,6 @@ bool mapShutdown(void)
 	}
 
 	map = NULL;
-	floodbucket = NULL;
 	psGroundTypes = NULL;
 	mapDecals = NULL;
 	psMapTiles = NULL;
@@ -1665,79 +1665,95 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
-// Flood fill a "continent".
-// TODO take into account scroll limits and update continents on scroll limit changes
-static void mapFloodFill(int x, int y, int continent, uint8_t blockedBits, uint16_t MAPTILE::*varContinent)
+/// Blocking bits for each continent class, for limited (land or sea) propulsion and for hover propulsion. A tile is in the first class
+/// whose bits it doesn't have.
+static const uint8_t limitedContinentBits[] = {WATER_BLOCKED | FEATURE_BLOCKED, LAND_BLOCKED | FEATURE_BLOCKED};
+static const uint8_t hoverContinentBits[] = {FEATURE_BLOCKED};
+
+static inline bool mapContinentTileOnMap(int x, int y)
 {
-	std::vector<Vector2i> open;
-	open.push_back(Vector2i(x, y));
-	mapTile(x, y)->*varContinent = continent;  // Set continent value
+	// All border tiles are inaccessible.
+	return x >= 1 && y >= 1 && x <= mapWidth - 2 && y <= mapHeight - 2;
+}
 
-	while (!open.empty())
+/// Returns 1 + the index of the first class in classBits which the tile is in, or 0 if the terrain of the tile blocks all classes.
+// TODO take into account scroll limits and update continents on scroll limit changes
+static int mapContinentClass(int x, int y, uint8_t const *classBits, int numClasses)
+{
+	if (!mapContinentTileOnMap(x, y))
 	{
-		// Pop the first open node off the list for this iteration
-		Vector2i pos = open.back();
-		open.pop_back();
-
-		// Add accessible neighbouring tiles to the open list
-		for (int i = 0; i < NUM_DIR; ++i)
+		return 0;
+	}
+	uint8_t bits = mapTerrainBlocking(mapTile(x, y));  // Only terrain, features come and go too often to be part of a continent.
+	for (int i = 0; i < numClasses; ++i)
+	{
+		if ((bits & classBits[i]) == 0)
 		{
-			// rely on the fact that all border tiles are inaccessible to avoid checking explicitly
-			Vector2i npos = pos + aDirOffset[i];
-
-			if (npos.x < 1 || npos.y < 1 || npos.x > mapWidth - 2 || npos.y > mapHeight - 2)
-			{
-				continue;
-			}
-			MAPTILE *psTile = mapTile(npos);
-
-			if (!(blockTile(npos.x, npos.y, AUX_MAP) & blockedBits) && psTile->*varContinent == 0)
-			{
-				open.push_back(npos);               // add to open list
-				psTile->*varContinent = continent;  // Set continent value
-			}
+			return i + 1;
 		}
 	}
+	return 0;
 }
 
-void mapFloodFillContinents()
+/// Sets the continent of every tile, numbering the continents in the order of their first tile.
+static int mapLabelContinents(uint16_t MAPTILE::*varContinent, uint8_t const *classBits, int numClasses)
 {
-	int x, y, limitedContinents = 0, hoverContinents = 0;
-
-	/* Clear continents */
-	for (y = 0; y < mapHeight; y++)
+	// Union-find over the tiles, joining each tile to the neighbours of the same class below it and to the right of it.
+	std::vector<uint8_t> tileClass(mapWidth * mapHeight);
+	std::vector<int> parent(mapWidth * mapHeight);
+	for (int i = 0; i < mapWidth * mapHeight; ++i)
 	{
-		for (x = 0; x < mapWidth; x++)
+		tileClass[i] = mapContinentClass(i % mapWidth, i / mapWidth, classBits, numClasses);
+		parent[i] = i;
+	}
+	auto find = [&](int i) {
+		while (parent[i] != i)
 		{
-			MAPTILE *psTile = mapTile(x, y);
-
-			psTile->limitedContinent = 0;
-			psTile->hoverContinent = 0;
+			i = parent[i] = parent[parent[i]];
 		}
-	}
-
-	/* Iterate over the whole map, looking for unset continents */
-	for (y = 1; y < mapHeight - 2; y++)
+		return i;
+	};
+	static const Vector2i laterOffset[] = {Vector2i(1, 0), Vector2i(-1, 1), Vector2i(0, 1), Vector2i(1, 1)};
+	for (int y = 1; y < mapHeight - 1; ++y)
 	{
-		for (x = 1; x < mapWidth - 2; x++)
+		for (int x = 1; x < mapWidth - 1; ++x)
 		{
-			MAPTILE *psTile = mapTile(x, y);
-
-			if (psTile->limitedContinent == 0 && !fpathBlockingTile(x, y, PROPULSION_TYPE_WHEELED))
+			int i = x + y * mapWidth;
+			if (tileClass[i] == 0)
 			{
-				mapFloodFill(x, y, 1 + limitedContinents++, WATER_BLOCKED | FEATURE_BLOCKED, &MAPTILE::limitedContinent);
+				continue;
 			}
-			else if (psTile->limitedContinent == 0 && !fpathBlockingTile(x, y, PROPULSION_TYPE_PROPELLOR))
+			for (unsigned dir = 0; dir < ARRAY_SIZE(laterOffset); ++dir)
 			{
-				mapFloodFill(x, y, 1 + limitedContinents++, LAND_BLOCKED | FEATURE_BLOCKED, &MAPTILE::limitedContinent);
+				int n = i + laterOffset[dir].x + laterOffset[dir].y * mapWidth;
+				if (tileClass[n] == tileClass[i])
+				{
+					int a = find(i), b = find(n);
+					parent[std::max(a, b)] = std::min(a, b);
+				}
 			}
+		}
+	}
 
-			if (psTile->hoverContinent == 0 && !fpathBlockingTile(x, y, PROPULSION_TYPE_HOVER))
-			{
-				mapFloodFill(x, y, 1 + hoverContinents++, FEATURE_BLOCKED, &MAPTILE::hoverContinent);
-			}
+	// Number the continents.
+	int numContinents = 0;
+	std::vector<uint16_t> continent(mapWidth * mapHeight, 0);
+	for (int i = 0; i < mapWidth * mapHeight; ++i)
+	{
+		uint16_t &rootContinent = continent[find(i)];
+		if (tileClass[i] != 0 && rootContinent == 0)
+		{
+			rootContinent = ++numContinents;
 		}
+		psMapTiles[i].*varContinent = tileClass[i] != 0 ? rootContinent : 0;
 	}
+	return numContinents;
+}
+
+void mapFloodFillContinents()
+{
+	int limitedContinents = mapLabelContinents(&MAPTILE::limitedContinent, limitedContinentBits, ARRAY_SIZE(limitedContinentBits));
+	int hoverContinents = mapLabelContinents(&MAPTILE::hoverContinent, hoverContinentBits, ARRAY_SIZE(hoverContinentBits));
 	debug(LOG_MAP, "Found %d limited and %d hover continents", limitedContinents, hoverContinents);
 }
 
@@ -1776,138 +1792,175 @@ bool fireOnLocation(unsigned int x, unsigned int y)
 	return psTile != NULL && TileIsBurning(psTile);
 }
 
-// This function runs in a separate thread!
-static int dangerFloodFill(int player)
+/// Copies what the flood fill needs from the aux and block maps, so that the game can carry on while the job runs.
+static void dangerPrepareJob(int player)
 {
-	int i;
+	DangerJob &job = dangerJobs[player];
 	Vector2i pos = getPlayerStartPosition(player);
-	Vector2i npos;
-	uint8_t aux, block;
-	int x, y;
-	bool start = true;	// hack to disregard the blocking status of any building exactly on the starting position
 
-	// Set our danger bits
-	for (y = 0; y < mapHeight; y++)
+	job.player = player;
+	job.start = Vector2i(clip(map_coord(pos.x), 0, mapWidth - 1), clip(map_coord(pos.y), 0, mapHeight - 1));
+	job.nonpassable.resize(mapWidth, mapHeight);
+	job.featureBlocked.resize(mapWidth, mapHeight);
+	for (int y = 0; y < mapHeight; ++y)
 	{
-		for (x = 0; x < mapWidth; x++)
-		{
-			auxSet(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY);
-		}
+		// Note that we do not consider water to be a blocker here. This may or may not be a feature...
+		job.nonpassable.setRowFromBytes(y, psAuxMap[player] + y * mapWidth, AUXBITS_NONPASSABLE, nullptr, 0);
+		job.featureBlocked.setRowFromBytes(y, nullptr, 0, psBlockMap[AUX_MAP] + y * mapWidth, FEATURE_BLOCKED);
 	}
+}
 
-	pos.x = map_coord(pos.x);
-	pos.y = map_coord(pos.y);
-	bucketcounter = 0;
+// This function runs on the worker threads!
+static void dangerFloodFill(DangerJob &job)
+{
+	int const width = job.nonpassable.getWidth(), height = job.nonpassable.getHeight();
+	uint16_t const *threat = &threatCount[job.player][THREAT_GROUND][0];
+	uint16_t const *aaThreat = &threatCount[job.player][THREAT_AIR][0];
+	bool start = true;	// hack to disregard the blocking status of any building exactly on the starting position
 
+	// Depth first search from the start position, through tiles without threat. Tiles next to the searched area which have a
+	// building, or which are entered from a tile with a feature, are safe too, but not searched from.
+	job.reached.resize(width, height);
+	job.safe.resize(width, height);
+	job.stack.clear();
+	Vector2i pos = job.start;
 	do
 	{
-		// Add accessible neighbouring tiles to the open list
-		for (i = 0; i < NUM_DIR; i++)
+		// Add accessible neighbouring tiles to the stack
+		for (int dir = 0; dir < NUM_DIR; ++dir)
 		{
-			npos.x = pos.x + aDirOffset[i].x;
-			npos.y = pos.y + aDirOffset[i].y;
-			if (!tileOnMap(npos.x, npos.y))
+			Vector2i npos = pos + aDirOffset[dir];
+			if (npos.x < 0 || npos.y < 0 || npos.x >= width || npos.y >= height
+			    || job.reached.get(npos.x, npos.y) || job.safe.get(npos.x, npos.y) || threat[npos.x + npos.y * width] != 0)
 			{
 				continue;
 			}
-			aux = auxTile(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP);
-			block = blockTile(pos.x, pos.y, AUX_DANGERMAP);
-			if (!(aux & AUXBITS_TEMPORARY) && !(aux & AUXBITS_THREAT) && (aux & AUXBITS_DANGER))
+			bool nonpassable = job.nonpassable.get(npos.x, npos.y);
+			if (!job.featureBlocked.get(pos.x, pos.y) && (!nonpassable || start))
 			{
-				// Note that we do not consider water to be a blocker here. This may or may not be a feature...
-				if (!(block & FEATURE_BLOCKED) && (!(aux & AUXBITS_NONPASSABLE) || start))
-				{
-					floodbucket[bucketcounter].x = npos.x;
-					floodbucket[bucketcounter].y = npos.y;
-					bucketcounter++;
-					if (start && !(aux & AUXBITS_NONPASSABLE))
-					{
-						start = false;
-					}
-				}
-				else
-				{
-					auxClear(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
-				}
-				auxSet(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY); // make sure we do not process it more than once
+				job.stack.push_back(npos);
+				start = start && nonpassable;
 			}
+			else
+			{
+				job.safe.set(npos.x, npos.y);
+			}
+			job.reached.set(npos.x, npos.y);  // make sure we do not process it more than once
 		}
 
-		// Clear danger
-		auxClear(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
+		job.safe.set(pos.x, pos.y);
 
-		// Pop the last open node off the bucket list for the next iteration
-		if (bucketcounter)
+		// Pop the last tile off the stack for the next iteration
+		if (!job.stack.empty())
 		{
-			bucketcounter--;
-			pos.x = floodbucket[bucketcounter].x;
-			pos.y = floodbucket[bucketcounter].y;
+			pos = job.stack.back();
+			job.stack.pop_back();
+		}
+	}
+	while (!job.stack.empty());
+
+	job.auxBits.resize(width * height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			int i = x + y * width;
+			job.auxBits[i] = (threat[i] != 0 ? AUXBITS_THREAT : 0) | (aaThreat[i] != 0 ? AUXBITS_AATHREAT : 0) | (!job.safe.get(x, y) ? AUXBITS_DANGER : 0);
 		}
 	}
-	while (bucketcounter);
-	return 0;
 }
 
-// This function runs in a separate thread!
-static int dangerThreadFunc(WZ_DECL_UNUSED void *data)
+/// Copies the result of a finished job to the aux map.
+static void dangerApplyJob(int player)
 {
-	while (lastDangerPlayer != -1)
+	DangerJob const &job = dangerJobs[player];
+	uint8_t const mask = AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT;
+
+	if (job.auxBits.size() != (size_t)mapWidth * mapHeight)
 	{
-		dangerFloodFill(lastDangerPlayer);	// Do the actual work
-		wzSemaphorePost(dangerDoneSemaphore);   // Signal that we are done
-		wzSemaphoreWait(dangerSemaphore);	// Go to sleep until needed.
+		return;  // Not for this map.
+	}
+	for (int i = 0; i < mapWidth * mapHeight; ++i)
+	{
+		psAuxMap[player][i] = (psAuxMap[player][i] & ~mask) | job.auxBits[i];
 	}
-	return 0;
 }
 
-static inline void threatUpdateTarget(int player, BASE_OBJECT *psObj, bool ground, bool air)
+/// Adds delta to the threat count of each tile the source was counted on.
+static void threatCountSource(ThreatSource const &source, int delta)
 {
-	int i;
-
-	if (psObj->visible[player] || psObj->born == 2)
+	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
-		for (i = 0; i < psObj->numWatchedTiles; i++)
+		if ((source.players & (PlayerMask)1 << player) == 0)
 		{
-			const TILEPOS pos = psObj->watchedTiles[i];
-
-			if (ground)
+			continue;
+		}
+		for (int type = 0; type < THREAT_TYPES; ++type)
+		{
+			if ((source.mode & (type == THREAT_GROUND ? SHOOT_ON_GROUND : SHOOT_IN_AIR)) == 0)
 			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT);	// set ground threat for this tile
+				continue;
 			}
-			if (air)
+			uint16_t *count = &threatCount[player][type][0];
+			for (TILEPOS const &pos : source.tiles)
 			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_AATHREAT);	// set air threat for this tile
+				count[pos.x + pos.y * mapWidth] += delta;
 			}
 		}
 	}
 }
 
-static void threatUpdate(int player)
+/// Updates the threat counts for an object, if it moved, or its weapons or who can see it changed since last time.
+static void threatUpdateSource(BASE_OBJECT *psObj, uint8_t mode)
 {
-	int i, weapon, x, y;
+	PlayerMask players = 0;
+	for (int player = 0; player < MAX_PLAYERS && mode != 0; ++player)
+	{
+		if (!aiCheckAlliances(player, psObj->player) && (psObj->visible[player] || psObj->born == 2))
+		{
+			players |= (PlayerMask)1 << player;
+		}
+	}
 
-	// Step 1: Clear our threat bits
-	for (y = 0; y < mapHeight; y++)
+	auto it = threatSources.find(psObj->id);
+	if (players == 0)
 	{
-		for (x = 0; x < mapWidth; x++)
+		if (it != threatSources.end())
 		{
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT);
+			threatCountSource(it->second, -1);
+			threatSources.erase(it);
 		}
+		return;
+	}
+	if (it == threatSources.end())
+	{
+		it = threatSources.insert(std::make_pair(psObj->id, ThreatSource())).first;
+	}
+	ThreatSource &source = it->second;
+	source.lastSeen = threatUpdateCount;
+	if (source.players == players && source.mode == mode && source.tiles.size() == (size_t)psObj->numWatchedTiles
+	    && std::equal(source.tiles.begin(), source.tiles.end(), psObj->watchedTiles, [](TILEPOS const &a, TILEPOS const &b) { return a.x == b.x && a.y == b.y; }))
+	{
+		return;  // Nothing changed.
 	}
+	threatCountSource(source, -1);
+	source.tiles.assign(psObj->watchedTiles, psObj->watchedTiles + psObj->numWatchedTiles);
+	source.players = players;
+	source.mode = mode;
+	threatCountSource(source, 1);
+}
+
+/// Updates the threat counts of all players, for the objects which changed since last time.
+static void threatUpdate()
+{
+	int i, weapon;
 
-	// Step 2: Set threat bits
+	++threatUpdateCount;
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		DROID *psDroid;
 		STRUCTURE *psStruct;
 
-		if (aiCheckAlliances(player, i))
-		{
-			// No need to iterate friendly objects
-			continue;
-		}
-
 		for (psDroid = apsDroidLists[i]; psDroid; psDroid = psDroid->psNext)
 		{
 			UBYTE mode = 0;
@@ -1925,10 +1978,7 @@ static void threatUpdate(int player)
 			{
 				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
 			}
-			if (mode > 0)
-			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psDroid, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
-			}
+			threatUpdateSource(psDroid, mode);
 		}
 
 		for (psStruct = apsStructLists[i]; psStruct; psStruct = psStruct->psNext)
@@ -1943,10 +1993,21 @@ static void threatUpdate(int player)
 			{
 				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
 			}
-			if (mode > 0)
-			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psStruct, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
-			}
+			threatUpdateSource(psStruct, mode);
+		}
+	}
+
+	// Forget objects which are gone.
+	for (auto it = threatSources.begin(); it != threatSources.end();)
+	{
+		if (it->second.lastSeen != threatUpdateCount)
+		{
+			threatCountSource(it->second, -1);
+			it = threatSources.erase(it);
+		}
+		else
+		{
+			++it;
 		}
 	}
 }
@@ -1955,31 +2016,31 @@ void mapInit()
 {
 	int player;
 
-	free(floodbucket);
-	floodbucket = (struct floodtile *)malloc(mapWidth * mapHeight * sizeof(*floodbucket));
-
 	lastDangerUpdate = 0;
-	lastDangerPlayer = -1;
+	threatSources.clear();
+	for (player = 0; player < MAX_PLAYERS; player++)
+	{
+		for (int type = 0; type < THREAT_TYPES; ++type)
+		{
+			threatCount[player][type].assign(mapWidth * mapHeight, 0);
+		}
+	}
 
 	// Initialize danger maps
+	threatUpdate();
 	for (player = 0; player < MAX_PLAYERS; player++)
 	{
-		auxMapStore(player, AUX_DANGERMAP);
-		threatUpdate(player);
-		dangerFloodFill(player);
-		auxMapRestore(player, AUX_DANGERMAP, AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT);
+		dangerPrepareJob(player);
 	}
-
-	// Start thread
-	ASSERT(dangerSemaphore == NULL && dangerThread == NULL, "Map data not cleaned up before starting!");
-	if (game.type == SKIRMISH)
+	workerPoolRun(MAX_PLAYERS, [](unsigned player)
+	{
+		dangerFloodFill(dangerJobs[player]);
+	});
+	for (player = 0; player < MAX_PLAYERS; player++)
 	{
-		lastDangerPlayer = 0;
-		dangerSemaphore = wzSemaphoreCreate(0);
-		dangerDoneSemaphore = wzSemaphoreCreate(0);
-		dangerThread = wzThreadCreate(dangerThreadFunc, NULL);
-		wzThreadStart(dangerThread);
+		dangerApplyJob(player);
 	}
+	dangerJobsDone = 0;
 }
 
 void mapUpdate()
@@ -2006,13 +2067,22 @@ void mapUpdate()
 		syncDebug("Do danger maps.");
 		lastDangerUpdate = gameTime;
 
-		// Lock if previous job not done yet
-		wzSemaphoreWait(dangerDoneSemaphore);
+		// Apply the results of the last round of jobs, so that every map is one interval old.
+		for (int player = 0; player < dangerJobsDone; ++player)
+		{
+			dangerApplyJob(player);
+		}
 
-		auxMapRestore(lastDangerPlayer, AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT | AUXBITS_DANGER);
-		lastDangerPlayer = (lastDangerPlayer + 1) % game.maxPlayers;
-		auxMapStore(lastDangerPlayer, AUX_DANGERMAP);
-		threatUpdate(lastDangerPlayer);
-		wzSemaphorePost(dangerSemaphore);
+		// Run the next round of jobs, for all players at once.
+		threatUpdate();
+		for (int player = 0; player < game.maxPlayers; ++player)
+		{
+			dangerPrepareJob(player);
+		}
+		workerPoolRun(game.maxPlayers, [](unsigned player)
+		{
+			dangerFloodFill(dangerJobs[player]);
+		});
+		dangerJobsDone = game.maxPlayers;
 	}
 }
@@ -332,6 +332,17 @@ static inline unsigned char terrainType(const MAPTILE *tile)
 	return terrainTypes[TileNumber_tile(tile->texture)];
 }
 
+/// Blocking bits given by the terrain of a tile, without any features or structures on it.
+static inline uint8_t mapTerrainBlocking(const MAPTILE *tile)
+{
+	uint8_t bits = terrainType(tile) == TER_WATER ? WATER_BLOCKED : LAND_BLOCKED;
+	if (terrainType(tile) == TER_CLIFFFACE)
+	{
+		bits |= FEATURE_BLOCKED;
+	}
+	return bits;
+}
+
 
 /* The maximum map size */
 
@@ -549,6 +560,7 @@ extern bool	writeVisibilityData(const char *fileName);
 //scroll min and max values
 extern SDWORD		scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
 
+/// Sets the continents of all tiles, from the terrain.
 void mapFloodFillContinents(void);
 
 extern void mapTest(void);
@@ -32,9 +32,24 @@
 #include "pointtree.h"
 
 
+/// An object in the point tree, with everything which affects where it goes in the point tree.
+struct GridObject
+{
+	bool operator ==(GridObject const &b) const
+	{
+		return psObj == b.psObj && id == b.id && order == b.order && x == b.x && y == b.y;
+	}
+
+	BASE_OBJECT *psObj;
+	uint32_t id;
+	uint32_t order;         ///< Order of the object in the object lists, for objects in the same place.
+	int32_t x, y;           ///< Position, only for structures and features, since droids are moved in place.
+};
+
 static PointTree *gridPointTree = NULL;  // A quad-tree-like object.
 static PointTree::Filter *gridFiltersUnseen;
 static PointTree::Filter *gridFiltersDroidsByPlayer;
+static std::vector<GridObject> gridObjects[PointTree::LAYERS];  ///< Objects in each layer of gridPointTree, in object list order.
 
 // initialise the grid system
 bool gridInitialise(void)
@@ -50,19 +65,36 @@ bool gridInitialise(void)
 // reset the grid system
 void gridReset(void)
 {
-	gridPointTree->clear();
+	// Objects are only put in the point tree again if one has been created or destroyed since last time. Otherwise, structures
+	// and features stay where they are, and droids are moved, which is cheap since they mostly stay in the same order.
+	bool changed[PointTree::LAYERS] = {false, false};
+	size_t count[PointTree::LAYERS] = {0, 0};
 
-	// Put all existing objects into the point tree.
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
 		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
 		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
 		{
+			PointTree::Layer layer = type == 0 ? PointTree::DYNAMIC : PointTree::STATIC;
+			std::vector<GridObject> &objects = gridObjects[layer];
+			uint32_t order = (player * 3 + type) << 24;  // Same order as when putting all the objects in a single list.
 			for (BASE_OBJECT *psObj = start[type]; psObj != NULL; psObj = psObj->psNext)
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
+					GridObject object = {psObj, psObj->id, order++, 0, 0};
+					if (layer == PointTree::STATIC)
+					{
+						object.x = psObj->pos.x;
+						object.y = psObj->pos.y;
+					}
+					if (count[layer] >= objects.size() || !(objects[count[layer]] == object))
+					{
+						changed[layer] = true;
+						objects.resize(count[layer]);
+						objects.push_back(object);
+					}
+					++count[layer];
 					for (unsigned viewer = 0; viewer < MAX_PLAYERS; ++viewer)
 					{
 						psObj->seenThisTick[viewer] = 0;
@@ -72,7 +104,33 @@ void gridReset(void)
 		}
 	}
 
-	gridPointTree->sort();
+	for (int layer = 0; layer < PointTree::LAYERS; ++layer)
+	{
+		std::vector<GridObject> &objects = gridObjects[layer];
+		if (count[layer] != objects.size())
+		{
+			changed[layer] = true;
+			objects.resize(count[layer]);
+		}
+		if (changed[layer])
+		{
+			gridPointTree->clear((PointTree::Layer)layer);
+			for (GridObject const &object : objects)
+			{
+				gridPointTree->insert((PointTree::Layer)layer, object.psObj, object.psObj->pos.x, object.psObj->pos.y, object.order);
+			}
+			gridPointTree->sort((PointTree::Layer)layer);
+		}
+	}
+	if (!changed[PointTree::DYNAMIC])
+	{
+		for (size_t i = 0; i < gridPointTree->size(PointTree::DYNAMIC); ++i)
+		{
+			BASE_OBJECT *psObj = (BASE_OBJECT *)gridPointTree->pointData(PointTree::DYNAMIC, i);
+			gridPointTree->move(PointTree::DYNAMIC, i, psObj->pos.x, psObj->pos.y);
+		}
+		gridPointTree->resort(PointTree::DYNAMIC);
+	}
 
 	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -86,6 +144,10 @@ void gridShutDown(void)
 {
 	delete gridPointTree;
 	gridPointTree = NULL;
+	for (int layer = 0; layer < PointTree::LAYERS; ++layer)
+	{
+		gridObjects[layer].clear();
+	}
 	delete[] gridFiltersUnseen;
 	gridFiltersUnseen = NULL;
 	delete[] gridFiltersDroidsByPlayer;
@@ -97,77 +159,88 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 	return (uint32_t)(x * x + y * y) <= radius * radius;
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
+// Find all objects within radius which pass the condition, and remove any which fail from the filter, so that they won't be
+// checked again by later searches with the same filter.
 template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+static void gridFindFiltered(GridList &list, int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
 {
-	if (filter == NULL)
+	list.clear();
+	gridPointTree->query(filter, x - radius, y - radius, x + radius, y + radius, [&](void *data, unsigned index)
 	{
-		gridPointTree->query(x, y, radius);
-	}
-	else
-	{
-		gridPointTree->query(*filter, x, y, radius);
-	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
-	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(data);
 		if (!condition.test(obj))  // Check if we should skip this object.
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
+			filter->erase(index);  // Stop the object from appearing in future searches.
 		}
 		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
 		{
-			*w = *i;
-			++w;
+			list.push_back(obj);
 		}
-	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
-	/*
-	// In case you are curious.
-	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
-	*/
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+	});
+}
+
+struct ConditionTrue
+{
+	bool test(BASE_OBJECT *) const
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		return true;
 	}
-	return gridList;
+};
+
+void gridFindObjects(GridList &list, int32_t x, int32_t y, uint32_t radius)
+{
+	gridFindFiltered(list, x, y, radius, NULL, ConditionTrue());
 }
 
-template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
+unsigned gridObjectCount()
 {
-	gridPointTree->query(x, y, x2, y2);
+	return gridPointTree->size(PointTree::STATIC) + gridPointTree->size(PointTree::DYNAMIC);
+}
 
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+void gridFindIndexedObjects(GridList &list, std::vector<unsigned> &indices, int32_t x, int32_t y, uint32_t radius)
+{
+	unsigned const dynamicStart = gridPointTree->size(PointTree::STATIC);
+	list.clear();
+	indices.clear();
+	gridPointTree->query(NULL, x - radius, y - radius, x + radius, y + radius, [&](void *data, unsigned index)
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
-	return gridList;
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(data);
+		if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))
+		{
+			list.push_back(obj);
+			indices.push_back((PointTree::indexLayer(index) == PointTree::DYNAMIC ? dynamicStart : 0) + PointTree::indexPoint(index));
+		}
+	});
 }
 
-struct ConditionTrue
+void gridFindNearbyObjects(GridList &list, int32_t x, int32_t y, uint32_t radius)
 {
-	bool test(BASE_OBJECT *) const
+	list.clear();
+	gridPointTree->query(NULL, x - radius, y - radius, x + radius, y + radius, [&](void *data, unsigned)
 	{
-		return true;
-	}
-};
+		list.push_back(static_cast<BASE_OBJECT *>(data));
+	});
+}
 
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+void gridFilterObjects(GridList &list, GridIterator begin, GridIterator end, int32_t x, int32_t y, uint32_t radius)
 {
-	return gridStartIterateFiltered(x, y, radius, NULL, ConditionTrue());
+	list.clear();
+	for (GridIterator gi = begin; gi != end; ++gi)
+	{
+		if (isInRadius((*gi)->pos.x - x, (*gi)->pos.y - y, radius))
+		{
+			list.push_back(*gi);
+		}
+	}
 }
 
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+void gridFindObjectsInArea(GridList &list, int32_t x, int32_t y, int32_t x2, int32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	list.clear();
+	gridPointTree->query(NULL, x, y, x2, y2, [&](void *data, unsigned)
+	{
+		list.push_back(static_cast<BASE_OBJECT *>(data));
+	});
 }
 
 struct ConditionDroidsByPlayer
@@ -180,9 +253,9 @@ struct ConditionDroidsByPlayer
 	int player;
 };
 
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+void gridFindDroidsByPlayer(GridList &list, int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
+	gridFindFiltered(list, x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
 }
 
 struct ConditionUnseen
@@ -195,15 +268,14 @@ struct ConditionUnseen
 	int player;
 };
 
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player)
+void gridFindUnseen(GridList &list, int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
+	gridFindFiltered(list, x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
 }
 
-BASE_OBJECT **gridIterateDup(void)
+GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 {
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	static GridList gridList;
+	gridFindObjects(gridList, x, y, radius);
+	return gridList;
 }
@@ -39,18 +39,41 @@ extern void gridShutDown(void);
 // Resets seenThisTick[] to false.
 extern void gridReset(void);
 
-/// Find all objects within radius.
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
+// The gridFind functions fill in a list owned by the caller, so the caller can keep using the list while searching again. They
+// don't modify the grid, so may be called from several threads at once, except that searches which use the same filter (the
+// same function and player) must not run at the same time. They must not run at the same time as gridReset.
 
 /// Find all objects within radius.
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
+void gridFindObjects(GridList &list, int32_t x, int32_t y, uint32_t radius);
+
+/// Number of objects in the grid. The indices from gridFindIndexedObjects are below this.
+unsigned gridObjectCount();
+
+/// Find all objects within radius, same as gridFindObjects, and a number for each, which is different for each object in the grid
+/// and stays the same until the next gridReset. Useful for remembering things about the objects found.
+void gridFindIndexedObjects(GridList &list, std::vector<unsigned> &indices, int32_t x, int32_t y, uint32_t radius);
+
+/** Find the objects which gridFindObjects would check the distance to. Which objects those are only depends on where objects were
+ *  at the last gridReset, so the search can be done before the objects move, and finished with gridFilterObjects afterwards.
+ */
+void gridFindNearbyObjects(GridList &list, int32_t x, int32_t y, uint32_t radius);
+
+/// Find the objects in [begin, end) which are within radius now. Given a list from gridFindNearbyObjects with the same x, y and
+/// radius, gives the same list as gridFindObjects, as long as there has been no gridReset in between.
+void gridFilterObjects(GridList &list, GridIterator begin, GridIterator end, int32_t x, int32_t y, uint32_t radius);
+
+/// Find all objects in the rectangle from (x, y) to (x2, y2), inclusive.
+void gridFindObjectsInArea(GridList &list, int32_t x, int32_t y, int32_t x2, int32_t y2);
 
 // Isn't, but could be used by some cluster system. Don't really understand what cluster.c is for.
 /// Find all objects within radius where object->type == OBJ_DROID && object->player == player.
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player);
+void gridFindDroidsByPlayer(GridList &list, int32_t x, int32_t y, uint32_t radius, int player);
 
 // Used for visibility.
 /// Find all objects within radius where object->seenThisTick[player] != 255.
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
+void gridFindUnseen(GridList &list, int32_t x, int32_t y, uint32_t radius, int player);
+
+/// Find all objects within radius. Not reentrant, the list is overwritten by the next call.
+GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
 #endif // __INCLUDED_SRC_MAPGRID_H__
@@ -327,6 +327,7 @@ bool missionShutDown(void)
 		apsOilList[0] = mission.apsOilList[0];
 		mission.apsSensorList[0] = NULL;
 		mission.apsOilList[0] = NULL;
+		objmemReindexLists();
 
 		psMapTiles = mission.psMapTiles;
 		mapWidth = mission.mapWidth;
@@ -793,6 +794,7 @@ static void saveMissionData(void)
 	}
 	mission.apsSensorList[0] = apsSensorList[0];
 	mission.apsOilList[0] = apsOilList[0];
+	objmemReindexLists();
 
 	mission.playerX = player.p.x;
 	mission.playerY = player.p.z;
@@ -862,6 +864,7 @@ void restoreMissionData(void)
 	apsSensorList[0] = mission.apsSensorList[0];
 	apsOilList[0] = mission.apsOilList[0];
 	mission.apsSensorList[0] = NULL;
+	objmemReindexLists();
 	//swap mission data over
 
 	psMapTiles = mission.psMapTiles;
@@ -1069,6 +1072,7 @@ void saveCampaignData(void)
 		// Reserve the droids for selected player for start of next campaign
 		mission.apsDroidLists[selectedPlayer] = apsDroidLists[selectedPlayer];
 		apsDroidLists[selectedPlayer] = NULL;
+		objmemReindexLists();
 		psDroid = mission.apsDroidLists[selectedPlayer];
 		while (psDroid != NULL)
 		{
@@ -1398,6 +1402,7 @@ void swapMissionPointers(void)
 	}
 	std::swap(apsSensorList[0], mission.apsSensorList[0]);
 	std::swap(apsOilList[0],    mission.apsOilList[0]);
+	objmemReindexLists();
 }
 
 void endMission(void)
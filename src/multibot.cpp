@@ -434,7 +434,7 @@ bool recvDroid(NETQUEUE queue)
 	// If we were able to build the droid set it up
 	if (psDroid)
 	{
-		psDroid->id = id;
+		setObjectId(psDroid, id);
 		addDroid(psDroid, apsDroidLists);
 
 		if (haveInitialOrders)
@@ -126,7 +126,7 @@ bool recvBuildFinished(NETQUEUE queue)
 		if (asStructureStats[typeindex].type == psStruct->pStructureType->type)
 		{
 			// Correct type, correct location, just rename the id's to sync it.. (urgh)
-			psStruct->id = structId;
+			setObjectId(psStruct, structId);
 			psStruct->status = SS_BUILT;
 			buildingComplete(psStruct);
 			debug(LOG_SYNC, "Created modified building %u for player %u", psStruct->id, player);
@@ -0,0 +1,127 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Slab allocator for game objects.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "objectpool.h"
+
+#include <algorithm>
+
+static std::vector<ObjectPool *> &allPools()
+{
+	static std::vector<ObjectPool *> pools;
+	return pools;
+}
+
+ObjectPool::ObjectPool(size_t size, const char *name_)
+	: objectSize(std::max((size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *), sizeof(FreeObject)))
+	, name(name_)
+	, freeList(nullptr)
+	, numLive(0)
+	, numFree(0)
+	, highWater(0)
+{
+	allPools().push_back(this);
+}
+
+ObjectPool::~ObjectPool()
+{
+	// Runs after the debug system is shut down, so just leak the slabs if any objects were never freed.
+	if (numLive == 0)
+	{
+		for (char *slab : slabs)
+		{
+			::operator delete(slab);
+		}
+	}
+	std::vector<ObjectPool *> &pools = allPools();
+	pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+}
+
+void *ObjectPool::alloc(size_t size)
+{
+	// Too big for the slots, such as a subclass, so get it from the system. Its size tells free() to give it back there.
+	if (size > objectSize)
+	{
+		return ::operator new(size);
+	}
+
+	if (freeList == nullptr)
+	{
+		char *slab = static_cast<char *>(::operator new(objectSize * SLAB_OBJECTS));
+		slabs.push_back(slab);
+		// Put the objects on the free list in order, so consecutive allocations are next to each other.
+		for (int i = SLAB_OBJECTS - 1; i >= 0; --i)
+		{
+			FreeObject *obj = reinterpret_cast<FreeObject *>(slab + i * objectSize);
+			obj->next = freeList;
+			freeList = obj;
+		}
+		numFree += SLAB_OBJECTS;
+	}
+
+	FreeObject *obj = freeList;
+	freeList = obj->next;
+	--numFree;
+	++numLive;
+	highWater = std::max(highWater, numLive);
+	return obj;
+}
+
+void ObjectPool::free(void *ptr, size_t size)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	if (size > objectSize)
+	{
+		::operator delete(ptr);  // Was too big for the pool, see alloc().
+		return;
+	}
+	ASSERT_OR_RETURN(, numLive > 0, "Freeing more %s objects than were allocated", name);
+	FreeObject *obj = static_cast<FreeObject *>(ptr);
+	obj->next = freeList;
+	freeList = obj;
+	++numFree;
+	--numLive;
+}
+
+ObjectPoolStats ObjectPool::stats() const
+{
+	ObjectPoolStats ret;
+	ret.name = name;
+	ret.live = numLive;
+	ret.free = numFree;
+	ret.highWater = highWater;
+	return ret;
+}
+
+std::vector<ObjectPoolStats> ObjectPool::allStats()
+{
+	std::vector<ObjectPoolStats> ret;
+	for (ObjectPool const *pool : allPools())
+	{
+		ret.push_back(pool->stats());
+	}
+	return ret;
+}
@@ -0,0 +1,92 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_OBJECTPOOL_H__
+#define __INCLUDED_SRC_OBJECTPOOL_H__
+
+#include "lib/framework/types.h"
+
+#include <vector>
+
+/// Counts of the objects in an ObjectPool.
+struct ObjectPoolStats
+{
+	const char *name;
+	size_t      live;       ///< Objects currently allocated.
+	size_t      free;       ///< Space for objects which has been allocated from the system, but isn't in use.
+	size_t      highWater;  ///< Most objects which have been allocated at the same time.
+};
+
+/** Allocates objects of one size from slabs, so that objects of the same type are close together in memory.
+ *
+ *  Objects never move once allocated, and the memory of freed objects is reused for new objects of the same type. The order
+ *  of the objects in memory doesn't affect the game state, since objects are still iterated in list order.
+ *
+ *  Used by the operator new and delete of DROID, STRUCTURE, FEATURE and PROJECTILE. Not thread safe.
+ */
+class ObjectPool
+{
+public:
+	ObjectPool(size_t size, const char *name);
+	~ObjectPool();
+
+	void *alloc(size_t size);
+	void free(void *ptr, size_t size);  ///< size must be the same as passed to alloc.
+	ObjectPoolStats stats() const;
+
+	/// Returns the statistics of all pools.
+	static std::vector<ObjectPoolStats> allStats();
+
+private:
+	enum
+	{
+		SLAB_OBJECTS = 64,  ///< Number of objects in each slab.
+	};
+
+	struct FreeObject
+	{
+		FreeObject *next;
+	};
+
+	ObjectPool(ObjectPool const &);            // Non-copyable.
+	void operator =(ObjectPool const &);       // Non-copyable.
+
+	size_t objectSize;
+	const char *name;
+	std::vector<char *> slabs;
+	FreeObject *freeList;
+	size_t numLive, numFree, highWater;
+};
+
+/// Declares operator new and delete for a type, which allocate from pool.
+#define OBJECT_POOL_ALLOCATED \
+	static void *operator new(size_t size); \
+	static void operator delete(void *ptr, size_t size)
+
+/// Defines the operator new and delete declared by OBJECT_POOL_ALLOCATED.
+#define DEFINE_OBJECT_POOL(type, pool) \
+	void *type::operator new(size_t size) \
+	{ \
+		return pool.alloc(size); \
+	} \
+	void type::operator delete(void *ptr, size_t size) \
+	{ \
+		pool.free(ptr, size); \
+	}
+
+#endif // __INCLUDED_SRC_OBJECTPOOL_H__
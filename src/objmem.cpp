@@ -24,6 +24,8 @@
  *
  */
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include "lib/framework/frame.h"
 #include "objects.h"
@@ -69,6 +71,21 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj = NULL;
 
+/** Index of all objects which have been added to a list and not destroyed, by id.
+ *
+ *  Open addressing hash table with linear probing. Ids are normally unique, but an id may be in the table more than once, if
+ *  for example a broken savegame has two objects with the same id.
+ */
+struct ObjectIdEntry
+{
+	BASE_OBJECT     *psObj;  ///< NULL if the slot is empty.
+	uint32_t        id;      ///< Same as psObj->id, kept here so that probing doesn't need to look at the objects.
+	unsigned        list;    ///< Which OBJECT_LIST the object is in.
+};
+static std::vector<ObjectIdEntry> objectIdIndex;
+static unsigned objectIdIndexBits = 0;  ///< objectIdIndex.size() == 1 << objectIdIndexBits, if not empty.
+static unsigned objectIdIndexCount = 0;
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck(void);
@@ -96,43 +113,58 @@ void objmemShutdown(void)
 #else
 #define BADREF(func, line) "Illegal reference to object %d", psVictim->id
 #endif
-static bool checkReferences(BASE_OBJECT *psVictim)
+
+/// If psTarget is one of the sorted victims, it is marked as still referenced, and returns false.
+static bool checkReference(std::vector<BASE_OBJECT *> const &victims, BASE_OBJECT *psReferrer, BASE_OBJECT *psTarget)
+{
+	if (psTarget == nullptr || psTarget == psReferrer)  // Don't worry about self references.
+	{
+		return true;
+	}
+	auto i = std::lower_bound(victims.begin(), victims.end(), psTarget);
+	if (i == victims.end() || *i != psTarget || ((*i)->flags & BASEFLAG_REFERENCED) != 0)
+	{
+		return true;  // Not a victim, or already complained about.
+	}
+	psTarget->flags |= BASEFLAG_REFERENCED;
+	return false;
+}
+
+/** Check that none of the victims are referred to by any other object in the game, and mark the ones which are.
+ *
+ *  Goes through all objects once, rather than once per victim, so freeing many objects at the same time doesn't take forever.
+ */
+static void checkReferences(std::vector<BASE_OBJECT *> const &victims)
 {
 	for (int plr = 0; plr < MAX_PLAYERS; ++plr)
 	{
 		for (STRUCTURE *psStruct = apsStructLists[plr]; psStruct != nullptr; psStruct = psStruct->psNext)
 		{
-			if (psStruct == psVictim)
-			{
-				continue;  // Don't worry about self references.
-			}
-
 			for (unsigned i = 0; i < psStruct->numWeaps; ++i)
 			{
-				ASSERT_OR_RETURN(false, psStruct->psTarget[i] != psVictim, BADREF(psStruct->targetFunc[i], psStruct->targetLine[i]));
+				BASE_OBJECT *psVictim = psStruct->psTarget[i];
+				bool ok = checkReference(victims, psStruct, psVictim);
+				ASSERT(ok, BADREF(psStruct->targetFunc[i], psStruct->targetLine[i]));
 			}
 		}
 		for (DROID *psDroid = apsDroidLists[plr]; psDroid != nullptr; psDroid = psDroid->psNext)
 		{
-			if (psDroid == psVictim)
-			{
-				continue;  // Don't worry about self references.
-			}
-
-			ASSERT_OR_RETURN(false, psDroid->order.psObj != psVictim, "Illegal reference to object %d", psVictim->id);
+			BASE_OBJECT *psVictim = psDroid->order.psObj;
+			bool ok = checkReference(victims, psDroid, psVictim);
+			ASSERT(ok, "Illegal reference to object %d", psVictim->id);
 
-			ASSERT_OR_RETURN(false, psDroid->psBaseStruct != psVictim, "Illegal reference to object %d", psVictim->id);
+			psVictim = psDroid->psBaseStruct;
+			ok = checkReference(victims, psDroid, psVictim);
+			ASSERT(ok, "Illegal reference to object %d", psVictim->id);
 
 			for (unsigned i = 0; i < psDroid->numWeaps; ++i)
 			{
-				if (psDroid->psActionTarget[i] == psVictim)
-				{
-					ASSERT_OR_RETURN(false, psDroid->psActionTarget[i] != psVictim, BADREF(psDroid->actionTargetFunc[i], psDroid->actionTargetLine[i]));
-				}
+				psVictim = psDroid->psActionTarget[i];
+				ok = checkReference(victims, psDroid, psVictim);
+				ASSERT(ok, BADREF(psDroid->actionTargetFunc[i], psDroid->actionTargetLine[i]));
 			}
 		}
 	}
-	return true;
 }
 
 /* Remove an object from the destroyed list, finally freeing its memory
@@ -156,9 +188,9 @@ static bool objmemDestroy(BASE_OBJECT *psObj)
 	default:
 		ASSERT(!"unknown object type", "unknown object type in destroyed list at 0x%p", psObj);
 	}
-	if (!checkReferences(psObj))
+	if ((psObj->flags & BASEFLAG_REFERENCED) != 0)
 	{
-		return false;
+		return false;  // Still referenced, so leak it rather than leave a dangling pointer.
 	}
 	debug(LOG_MEMORY, "BASE_OBJECT* 0x%p is freed.", psObj);
 	delete psObj;
@@ -183,6 +215,21 @@ void objmemUpdate(void)
 
 	/* Go through the destroyed objects list looking for objects that
 	   were destroyed before this turn */
+	static std::vector<BASE_OBJECT *> victims;
+	victims.clear();
+	for (psCurr = psDestroyedObj; psCurr != nullptr; psCurr = psCurr->psNext)
+	{
+		if (psCurr->died <= gameTime - deltaGameTime)
+		{
+			psCurr->flags &= ~BASEFLAG_REFERENCED;  // Only references found in this check count.
+			victims.push_back(psCurr);
+		}
+	}
+	if (!victims.empty())
+	{
+		std::sort(victims.begin(), victims.end());
+		checkReferences(victims);
+	}
 
 	/* First remove the objects from the start of the list */
 	while (psDestroyedObj != nullptr && psDestroyedObj->died <= gameTime - deltaGameTime)
@@ -245,6 +292,216 @@ uint32_t generateSynchronisedObjectId(void)
 	return ret;
 }
 
+/**************************  OBJECT ID INDEX  *********************************/
+
+static inline unsigned objectIdSlot(uint32_t id)
+{
+	return id * 2654435761u >> (32 - objectIdIndexBits);
+}
+
+/// Returns the entry of the object, or NULL if it isn't in the index.
+static ObjectIdEntry *objectIdFind(BASE_OBJECT const *psObj, uint32_t id)
+{
+	if (objectIdIndex.empty())
+	{
+		return NULL;
+	}
+	unsigned mask = objectIdIndex.size() - 1;
+	for (unsigned slot = objectIdSlot(id); objectIdIndex[slot].psObj != NULL; slot = (slot + 1) & mask)
+	{
+		if (objectIdIndex[slot].psObj == psObj)
+		{
+			return &objectIdIndex[slot];
+		}
+	}
+	return NULL;
+}
+
+static void objectIdInsertNew(BASE_OBJECT *psObj, unsigned list)
+{
+	unsigned mask = objectIdIndex.size() - 1;
+	unsigned slot = objectIdSlot(psObj->id);
+	while (objectIdIndex[slot].psObj != NULL)
+	{
+		slot = (slot + 1) & mask;
+	}
+	objectIdIndex[slot].psObj = psObj;
+	objectIdIndex[slot].id = psObj->id;
+	objectIdIndex[slot].list = list;
+	++objectIdIndexCount;
+}
+
+/// Adds the object to the index, or updates which list it is in if it's already there.
+static void objectIdInsert(BASE_OBJECT *psObj, unsigned list)
+{
+	if (ObjectIdEntry *entry = objectIdFind(psObj, psObj->id))
+	{
+		entry->list = list;
+		return;
+	}
+
+	// Keep the table at most half full, so probes stay short.
+	if ((objectIdIndexCount + 1) * 2 > objectIdIndex.size())
+	{
+		std::vector<ObjectIdEntry> old;
+		old.swap(objectIdIndex);
+		objectIdIndexBits = std::max(objectIdIndexBits + 1, 10u);
+		ObjectIdEntry empty = {NULL, 0, 0};
+		objectIdIndex.assign(1 << objectIdIndexBits, empty);
+		objectIdIndexCount = 0;
+		for (ObjectIdEntry const &entry : old)
+		{
+			if (entry.psObj != NULL)
+			{
+				objectIdInsertNew(entry.psObj, entry.list);
+			}
+		}
+	}
+	objectIdInsertNew(psObj, list);
+}
+
+static void objectIdRemove(BASE_OBJECT const *psObj, uint32_t id)
+{
+	ObjectIdEntry *entry = objectIdFind(psObj, id);
+	if (entry == NULL)
+	{
+		return;
+	}
+	entry->psObj = NULL;
+	--objectIdIndexCount;
+
+	// Move later entries of the same probe sequence back into the hole, so lookups don't stop early.
+	unsigned mask = objectIdIndex.size() - 1;
+	unsigned hole = entry - &objectIdIndex[0];
+	for (unsigned slot = (hole + 1) & mask; objectIdIndex[slot].psObj != NULL; slot = (slot + 1) & mask)
+	{
+		unsigned home = objectIdSlot(objectIdIndex[slot].id);
+		if (((slot - home) & mask) >= ((slot - hole) & mask))
+		{
+			objectIdIndex[hole] = objectIdIndex[slot];
+			objectIdIndex[slot].psObj = NULL;
+			hole = slot;
+		}
+	}
+}
+
+/// Which OBJECT_LIST a list is.
+template <typename OBJECT>
+static unsigned objectListType(OBJECT *list[])
+{
+	if (list == (OBJECT **)apsDroidLists || list == (OBJECT **)apsStructLists || list == (OBJECT **)apsFeatureLists)
+	{
+		return OBJLIST_CURRENT;
+	}
+	if (list == (OBJECT **)mission.apsDroidLists || list == (OBJECT **)mission.apsStructLists || list == (OBJECT **)mission.apsFeatureLists)
+	{
+		return OBJLIST_MISSION;
+	}
+	if (list == (OBJECT **)apsLimboDroids)
+	{
+		return OBJLIST_LIMBO;
+	}
+	return OBJLIST_NONE;
+}
+
+BASE_OBJECT *findObjectById(uint32_t id, OBJECT_TYPE type, unsigned player, unsigned lists)
+{
+	if (objectIdIndex.empty())
+	{
+		return NULL;
+	}
+	unsigned mask = objectIdIndex.size() - 1;
+	for (unsigned slot = objectIdSlot(id); objectIdIndex[slot].psObj != NULL; slot = (slot + 1) & mask)
+	{
+		ObjectIdEntry const &entry = objectIdIndex[slot];
+		if (entry.id == id && (entry.list & lists) != 0 && entry.psObj->type == type &&
+		    (player >= MAX_PLAYERS || type == OBJ_FEATURE || entry.psObj->player == player))
+		{
+			return entry.psObj;
+		}
+	}
+	return NULL;
+}
+
+void setObjectId(BASE_OBJECT *psObj, uint32_t id)
+{
+	ObjectIdEntry *entry = objectIdFind(psObj, psObj->id);
+	if (entry == NULL)
+	{
+		psObj->id = id;
+		return;
+	}
+	unsigned list = entry->list;
+	objectIdRemove(psObj, psObj->id);
+	psObj->id = id;
+	objectIdInsert(psObj, list);
+}
+
+void objmemForgetObject(BASE_OBJECT *psObj)
+{
+	objectIdRemove(psObj, psObj->id);  // Ids are only changed with setObjectId(), so the entry is found, if there is one.
+}
+
+template <typename OBJECT>
+static void reindexList(OBJECT *list[], unsigned listType)
+{
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (OBJECT *psObj = list[player]; psObj != NULL; psObj = psObj->psNext)
+		{
+			ObjectIdEntry *entry = objectIdFind(psObj, psObj->id);
+			if (entry != NULL)
+			{
+				entry->list |= listType;  // In more than one list, since the lists are the same.
+				continue;
+			}
+			objectIdInsert(psObj, listType);
+		}
+	}
+}
+
+/// Adds the droids in transporters, which aren't in any list.
+static void reindexTransporters(DROID *list[])
+{
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = list[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if (isTransporter(psDroid) && psDroid->psGroup != NULL)
+			{
+				for (DROID *psCargo = psDroid->psGroup->psList; psCargo != NULL; psCargo = psCargo->psGrpNext)
+				{
+					if (psCargo != psDroid && objectIdFind(psCargo, psCargo->id) == NULL)
+					{
+						objectIdInsert(psCargo, OBJLIST_NONE);
+					}
+				}
+			}
+		}
+	}
+}
+
+void objmemReindexLists()
+{
+	ObjectIdEntry empty = {NULL, 0, 0};
+	std::fill(objectIdIndex.begin(), objectIdIndex.end(), empty);
+	objectIdIndexCount = 0;
+
+	// The current and mission lists may be the same lists, as after saveMissionData(), in which case the objects are in both.
+	reindexList(apsDroidLists, OBJLIST_CURRENT);
+	reindexList(apsStructLists, OBJLIST_CURRENT);
+	reindexList(apsFeatureLists, OBJLIST_CURRENT);
+	reindexList(mission.apsDroidLists, OBJLIST_MISSION);
+	reindexList(mission.apsStructLists, OBJLIST_MISSION);
+	reindexList(mission.apsFeatureLists, OBJLIST_MISSION);
+	reindexList(apsLimboDroids, OBJLIST_LIMBO);
+	reindexTransporters(apsDroidLists);
+	reindexTransporters(mission.apsDroidLists);
+	reindexTransporters(apsLimboDroids);
+}
+
+/**************************  OBJECT LISTS  *********************************/
+
 /* Add the object to its list
  * \param list is a pointer to the object list
  */
@@ -256,6 +513,8 @@ static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 	// Prepend the object to the top of the list
 	object->psNext = list[player];
 	list[player] = object;
+
+	objectIdInsert(object, objectListType(list));
 }
 
 /* Add the object to its list
@@ -282,6 +541,8 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	ASSERT_OR_RETURN(, object != NULL, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
+	objectIdRemove(object, object->id);  // Destroyed objects can't be found by id.
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[object->player] == object)
 	{
@@ -328,6 +589,11 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 {
 	ASSERT_OR_RETURN(, object != NULL, "Invalid pointer");
 
+	if (ObjectIdEntry *entry = objectIdFind(object, object->id))
+	{
+		entry->list = OBJLIST_NONE;  // Can still be found, until destroyed, since it may be going into a transporter.
+	}
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[player] == object)
 	{
@@ -771,145 +1037,22 @@ void checkFactoryFlags(void)
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
 {
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
+	// Droids in transporters aren't in any list, so look in OBJLIST_NONE too.
+	BASE_OBJECT *psObj = findObjectById(id, type, player, OBJLIST_ALL);
+	ASSERT(psObj != NULL, "failed to find id %d for player %d", id, player);
 
-	for (int i = 0; i < 3; ++i)
-	{
-		psObj = NULL;
-		switch (i)
-		{
-		case 0:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = apsFeatureLists[0];
-			default: break;
-			}
-			break;
-		case 1:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = mission.apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = mission.apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = mission.apsFeatureLists[0]; break;
-			default: break;
-			}
-			break;
-		case 2:
-			if (player == 0 && type == OBJ_DROID)
-			{
-				psObj = apsLimboDroids[0];
-			}
-			break;
-		}
-
-		while (psObj)
-		{
-			if (psObj->id == id)
-			{
-				return psObj;
-			}
-			// if transporter check any droids in the grp
-			if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-			{
-				for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != NULL; psTrans = psTrans->psGrpNext)
-				{
-					if (psTrans->id == id)
-					{
-						return (BASE_OBJECT *)psTrans;
-					}
-				}
-			}
-			psObj = psObj->psNext;
-		}
-	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
-
-	return NULL;
+	return psObj;
 }
 
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromId(UDWORD id)
 {
-	unsigned int i;
-	UDWORD			player;
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
-
-	for (i = 0; i < 7; ++i)
+	static const OBJECT_TYPE types[] = {OBJ_DROID, OBJ_STRUCTURE, OBJ_FEATURE};
+	for (unsigned i = 0; i < ARRAY_SIZE(types); ++i)
 	{
-		for (player = 0; player < MAX_PLAYERS; ++player)
+		if (BASE_OBJECT *psObj = findObjectById(id, types[i], MAX_PLAYERS, OBJLIST_ALL))
 		{
-			switch (i)
-			{
-			case 0:
-				psObj = (BASE_OBJECT *)apsDroidLists[player];
-				break;
-			case 1:
-				psObj = (BASE_OBJECT *)apsStructLists[player];
-				break;
-			case 2:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			case 3:
-				psObj = (BASE_OBJECT *)mission.apsDroidLists[player];
-				break;
-			case 4:
-				psObj = (BASE_OBJECT *)mission.apsStructLists[player];
-				break;
-			case 5:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)mission.apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			case 6:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsLimboDroids[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			default:
-				psObj = NULL;
-				break;
-			}
-
-			while (psObj)
-			{
-				if (psObj->id == id)
-				{
-					return psObj;
-				}
-				// if transporter check any droids in the grp
-				if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-				{
-					for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != NULL; psTrans = psTrans->psGrpNext)
-					{
-						if (psTrans->id == id)
-						{
-							return (BASE_OBJECT *)psTrans;
-						}
-					}
-				}
-				psObj = psObj->psNext;
-			}
+			return psObj;
 		}
 	}
 	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
@@ -1008,7 +1151,33 @@ static void objListIntegCheck(void)
 	for (psCurr = (BASE_OBJECT *)psDestroyedObj; psCurr; psCurr = psCurr->psNext)
 	{
 		ASSERT(psCurr->died > 0, "objListIntegCheck: Object in destroyed list but not dead!");
+		ASSERT(objectIdFind(psCurr, psCurr->id) == NULL, "objListIntegCheck: %s(%p) is destroyed, but still in the id index", objInfo(psCurr), psCurr);
+	}
+
+	// Objects in the current lists must be findable by id. (The mission lists may be the same lists, while saving mission data.)
+	for (player = 0; player < MAX_PLAYERS; player += 1)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			psCurr = i == 0 ? (BASE_OBJECT *)apsDroidLists[player] : i == 1 ? (BASE_OBJECT *)apsStructLists[player] : (BASE_OBJECT *)apsFeatureLists[player];
+			for (; psCurr; psCurr = psCurr->psNext)
+			{
+				ObjectIdEntry const *entry = objectIdFind(psCurr, psCurr->id);
+				ASSERT(entry != NULL && (entry->list & (OBJLIST_CURRENT | OBJLIST_MISSION)) != 0,
+				       "objListIntegCheck: %s(%p) is missing from the id index, or indexed in the wrong list", objInfo(psCurr), psCurr);
+			}
+		}
+	}
+	unsigned count = 0;
+	for (ObjectIdEntry const &entry : objectIdIndex)
+	{
+		if (entry.psObj != NULL)
+		{
+			ASSERT(entry.psObj->id == entry.id, "objListIntegCheck: %s(%p) has id %u in the id index", objInfo(entry.psObj), entry.psObj, entry.id);
+			++count;
+		}
 	}
+	ASSERT(count == objectIdIndexCount, "objListIntegCheck: id index has %u entries, expected %u", count, objectIdIndexCount);
 }
 #endif
 
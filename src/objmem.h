@@ -102,6 +102,35 @@ extern void removeFlagPosition(FLAG_POSITION *psDel);
 extern void freeAllFlagPositions(void);
 extern void freeAllAssemblyPoints(void);
 
+/// Lists which an object can be in, for findObjectById.
+enum OBJECT_LIST
+{
+	OBJLIST_CURRENT = 1,  ///< apsDroidLists, apsStructLists and apsFeatureLists.
+	OBJLIST_MISSION = 2,  ///< mission.apsDroidLists, mission.apsStructLists and mission.apsFeatureLists.
+	OBJLIST_LIMBO   = 4,  ///< apsLimboDroids.
+	OBJLIST_NONE    = 8,  ///< Not destroyed, but in none of the lists, such as droids in a transporter.
+	OBJLIST_ALL     = 15,
+};
+
+/** Finds an object by id, without searching the lists. Returns NULL if there is no such object.
+ *
+ *  @param type Type of the object.
+ *  @param player Owner of the object, or any player if ≥ MAX_PLAYERS. Ignored for features.
+ *  @param lists The OBJECT_LIST bits of the lists which the object may be in.
+ */
+BASE_OBJECT *findObjectById(uint32_t id, OBJECT_TYPE type, unsigned player, unsigned lists);
+
+/// Changes the id of an object, which may already be in a list.
+void setObjectId(BASE_OBJECT *psObj, uint32_t id);
+
+/** Rebuilds the index used by findObjectById from the object lists and the transporters in them. Must be called after whole
+ *  lists have been moved between the current, mission and limbo lists, or set without using addDroid, removeDroid etc.
+ */
+void objmemReindexLists(void);
+
+/// Removes an object from the index used by findObjectById. Called when the object is freed.
+void objmemForgetObject(BASE_OBJECT *psObj);
+
 // Find a base object from it's id
 extern BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 extern BASE_OBJECT *getBaseObjFromId(UDWORD id);
@@ -0,0 +1,39 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_PATHCOST_H__
+#define __INCLUDED_SRC_PATHCOST_H__
+
+#include "lib/framework/types.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+/** Cost of the shortest route across dx, dy tiles on an open map, 140 for each horizontal/vertical move, and 198 for each diagonal
+ *  move. A*, Jump Point Search, flow fields and the cluster graph must all use this, so they find routes of the same length.
+ *
+ *  @ingroup pathfinding
+ */
+static inline unsigned fpathMoveCost(int dx, int dy)
+{
+	// Cost of moving horizontal/vertical = 70*2, cost of moving diagonal = 99*2, 99/70 = 1.41428571... ≈ √2 = 1.41421356...
+	unsigned xDelta = abs(dx), yDelta = abs(dy);
+	return std::min(xDelta, yDelta) * (198 - 140) + std::max(xDelta, yDelta) * 140;
+}
+
+#endif // __INCLUDED_SRC_PATHCOST_H__
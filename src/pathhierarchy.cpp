@@ -0,0 +1,415 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Cluster and portal graph for hierarchical pathfinding.
+ *  See "Near Optimal Hierarchical Path-Finding" (Botea, Müller, Schaeffer) for the general idea.
+ *
+ *  Each run of open tiles along the border between two clusters gets one portal, in the middle of the run. The tiles either side of
+ *  a portal are the entrances of the clusters. Costs between entrances of the same cluster are found with Dijkstra, only moving
+ *  within the cluster, using the same move costs and corner cutting rules as fpathAStarExplore, so any route on the graph can also
+ *  be walked without leaving the clusters it passes through.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "pathhierarchy.h"
+#include "pathcost.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+static const uint32_t NO_ROUTE = 0xFFFFFFFF;
+static const unsigned NO_NODE = 0xFFFFFFFF;
+
+PathHierarchy::PathHierarchy(TileBitmap const &map_, PathHierarchy const *previous, TileBitmap const *changed)
+	: width(map_.getWidth())
+	, height(map_.getHeight())
+	, clustersX((width + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+	, clustersY((height + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+{
+	unsigned numClusters = clustersX * clustersY;
+	bool reuse = previous != nullptr && changed != nullptr && previous->width == width && previous->height == height &&
+	             changed->getWidth() == width && changed->getHeight() == height;
+
+	std::vector<bool> dirty(numClusters, !reuse);
+	if (reuse)
+	{
+		// Look at a word at a time, skipping words with no changes.
+		for (int y = 0; y < height; ++y)
+		{
+			uint64_t const *row = changed->row(y);
+			for (int w = 0; w < changed->rowWords(); ++w)
+			{
+				uint64_t bits = row[w];
+				for (int bit = 0; bits != 0; ++bit, bits >>= 1)
+				{
+					if ((bits & 1) != 0)
+					{
+						dirty[clusterOf(w * 64 + bit, y)] = true;
+					}
+				}
+			}
+		}
+		clusters = previous->clusters;
+		portalsRight = previous->portalsRight;
+		portalsDown = previous->portalsDown;
+	}
+	else
+	{
+		clusters.resize(numClusters);
+		portalsRight.resize(numClusters);
+		portalsDown.resize(numClusters);
+	}
+
+	// Portals only depend on the tiles of the clusters either side of the border.
+	for (unsigned c = 0; c < numClusters; ++c)
+	{
+		int cx = c % clustersX, cy = c / clustersX;
+		if (cx + 1 < clustersX && (dirty[c] || dirty[c + 1]))
+		{
+			findPortals(map_, c, c + 1, true, portalsRight[c]);
+		}
+		if (cy + 1 < clustersY && (dirty[c] || dirty[c + clustersX]))
+		{
+			findPortals(map_, c, c + clustersX, false, portalsDown[c]);
+		}
+	}
+
+	// Entrances depend on the portals on all four sides, costs depend on the entrances and on the tiles of the cluster.
+	for (unsigned c = 0; c < numClusters; ++c)
+	{
+		int cx = c % clustersX, cy = c / clustersX;
+		bool touched = dirty[c] || (cx > 0 && dirty[c - 1]) || (cx + 1 < clustersX && dirty[c + 1]) ||
+		               (cy > 0 && dirty[c - clustersX]) || (cy + 1 < clustersY && dirty[c + clustersX]);
+		if (!touched)
+		{
+			continue;
+		}
+		std::vector<uint32_t> entrances;
+		findEntrances(c, entrances);
+		if (!dirty[c] && entrances == clusters[c].entrances)
+		{
+			continue;  // Nothing changed, so the costs are still correct.
+		}
+		clusters[c].entrances.swap(entrances);
+		findCosts(map_, c);
+	}
+
+	linkNodes();
+}
+
+void PathHierarchy::clusterBounds(unsigned cluster, int &x1, int &y1, int &x2, int &y2) const
+{
+	x1 = cluster % clustersX * CLUSTER_SIZE;
+	y1 = cluster / clustersX * CLUSTER_SIZE;
+	x2 = std::min(x1 + CLUSTER_SIZE, width);
+	y2 = std::min(y1 + CLUSTER_SIZE, height);
+}
+
+void PathHierarchy::findPortals(TileBitmap const &map_, unsigned clusterA, unsigned clusterB, bool horizontal, std::vector<Portal> &portals) const
+{
+	int ax1, ay1, ax2, ay2;
+	int bx1, by1, bx2, by2;
+	clusterBounds(clusterA, ax1, ay1, ax2, ay2);
+	clusterBounds(clusterB, bx1, by1, bx2, by2);
+
+	portals.clear();
+	// Walk along the border, with a on the clusterA side and b on the clusterB side.
+	Vector2i a = horizontal ? Vector2i(ax2 - 1, ay1) : Vector2i(ax1, ay2 - 1);
+	Vector2i b(bx1, by1);
+	Vector2i step = horizontal ? Vector2i(0, 1) : Vector2i(1, 0);
+	int length = horizontal ? ay2 - ay1 : ax2 - ax1;
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i)
+	{
+		Vector2i pa = a + step * i, pb = b + step * i;
+		bool open = i < length && !map_.get(pa.x, pa.y) && !map_.get(pb.x, pb.y);
+		if (open && runStart == -1)
+		{
+			runStart = i;
+		}
+		else if (!open && runStart != -1)
+		{
+			int mid = (runStart + i - 1) / 2;
+			Vector2i ma = a + step * mid, mb = b + step * mid;
+			Portal portal = {uint32_t(ma.x + ma.y * width), uint32_t(mb.x + mb.y * width)};
+			portals.push_back(portal);
+			runStart = -1;
+		}
+	}
+}
+
+void PathHierarchy::findEntrances(unsigned cluster, std::vector<uint32_t> &entrances) const
+{
+	int cx = cluster % clustersX, cy = cluster / clustersX;
+
+	entrances.clear();
+	for (Portal const &portal : portalsRight[cluster])
+	{
+		entrances.push_back(portal.tileA);
+	}
+	for (Portal const &portal : portalsDown[cluster])
+	{
+		entrances.push_back(portal.tileA);
+	}
+	if (cx > 0)
+	{
+		for (Portal const &portal : portalsRight[cluster - 1])
+		{
+			entrances.push_back(portal.tileB);
+		}
+	}
+	if (cy > 0)
+	{
+		for (Portal const &portal : portalsDown[cluster - clustersX])
+		{
+			entrances.push_back(portal.tileB);
+		}
+	}
+	std::sort(entrances.begin(), entrances.end());
+	entrances.erase(std::unique(entrances.begin(), entrances.end()), entrances.end());
+}
+
+void PathHierarchy::clusterDistances(TileBitmap const &map_, unsigned cluster, uint32_t startTile, std::vector<uint32_t> &dist) const
+{
+	static const Vector2i dirs[8] = {Vector2i(0, 1), Vector2i(-1, 1), Vector2i(-1, 0), Vector2i(-1, -1), Vector2i(0, -1), Vector2i(1, -1), Vector2i(1, 0), Vector2i(1, 1)};
+
+	int x1, y1, x2, y2;
+	clusterBounds(cluster, x1, y1, x2, y2);
+	int w = x2 - x1;
+	auto blocked = [&](int x, int y) {
+		return x < x1 || y < y1 || x >= x2 || y >= y2 || map_.get(x, y);
+	};
+
+	dist.assign(w * (y2 - y1), NO_ROUTE);
+	typedef std::pair<uint32_t, uint32_t> Open;  // Distance, local tile index.
+	std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+	int sx = startTile % width, sy = startTile / width;
+	dist[(sx - x1) + (sy - y1) * w] = 0;
+	open.push(Open(0, (sx - x1) + (sy - y1) * w));
+	while (!open.empty())
+	{
+		Open cur = open.top();
+		open.pop();
+		if (cur.first != dist[cur.second])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		int x = x1 + cur.second % w, y = y1 + cur.second / w;
+		for (unsigned dir = 0; dir < 8; ++dir)
+		{
+			int nx = x + dirs[dir].x, ny = y + dirs[dir].y;
+			// We cannot cut corners, same as fpathAStarExplore.
+			if (dir % 2 != 0 && (blocked(x + dirs[(dir + 1) % 8].x, y + dirs[(dir + 1) % 8].y) || blocked(x + dirs[(dir + 7) % 8].x, y + dirs[(dir + 7) % 8].y)))
+			{
+				continue;
+			}
+			if (blocked(nx, ny))
+			{
+				continue;
+			}
+			uint32_t newDist = cur.first + fpathMoveCost(dirs[dir].x, dirs[dir].y);
+			uint32_t &oldDist = dist[(nx - x1) + (ny - y1) * w];
+			if (newDist < oldDist)
+			{
+				oldDist = newDist;
+				open.push(Open(newDist, (nx - x1) + (ny - y1) * w));
+			}
+		}
+	}
+}
+
+void PathHierarchy::findCosts(TileBitmap const &map_, unsigned cluster)
+{
+	Cluster &c = clusters[cluster];
+	int x1, y1, x2, y2;
+	clusterBounds(cluster, x1, y1, x2, y2);
+	int w = x2 - x1;
+
+	unsigned n = c.entrances.size();
+	c.costs.assign(n * n, NO_ROUTE);
+	std::vector<uint32_t> dist;
+	for (unsigned i = 0; i < n; ++i)
+	{
+		clusterDistances(map_, cluster, c.entrances[i], dist);
+		for (unsigned j = 0; j < n; ++j)
+		{
+			int x = c.entrances[j] % width, y = c.entrances[j] / width;
+			c.costs[i * n + j] = dist[(x - x1) + (y - y1) * w];
+		}
+	}
+}
+
+unsigned PathHierarchy::nodeOf(uint32_t tile) const
+{
+	Cluster const &c = clusters[clusterOf(tile % width, tile / width)];
+	auto i = std::lower_bound(c.entrances.begin(), c.entrances.end(), tile);
+	ASSERT_OR_RETURN(NO_NODE, i != c.entrances.end() && *i == tile, "Portal tile %u is not an entrance.", tile);
+	return c.firstNode + (i - c.entrances.begin());
+}
+
+void PathHierarchy::linkNodes()
+{
+	nodes.clear();
+	for (Cluster &c : clusters)
+	{
+		c.firstNode = nodes.size();
+		nodes.insert(nodes.end(), c.entrances.begin(), c.entrances.end());
+	}
+
+	std::vector<std::vector<Edge>> links(nodes.size());
+	for (Cluster const &c : clusters)
+	{
+		unsigned n = c.entrances.size();
+		for (unsigned i = 0; i < n; ++i)
+		{
+			for (unsigned j = 0; j < n; ++j)
+			{
+				if (i != j && c.costs[i * n + j] != NO_ROUTE)
+				{
+					Edge edge = {c.firstNode + j, c.costs[i * n + j]};
+					links[c.firstNode + i].push_back(edge);
+				}
+			}
+		}
+	}
+	for (unsigned cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		for (int side = 0; side < 2; ++side)
+		{
+			for (Portal const &portal : side == 0 ? portalsRight[cluster] : portalsDown[cluster])
+			{
+				unsigned a = nodeOf(portal.tileA), b = nodeOf(portal.tileB);
+				if (a == NO_NODE || b == NO_NODE)
+				{
+					continue;
+				}
+				Edge ab = {b, fpathMoveCost(1, 0)}, ba = {a, fpathMoveCost(1, 0)};
+				links[a].push_back(ab);
+				links[b].push_back(ba);
+			}
+		}
+	}
+
+	nodeEdges.clear();
+	edges.clear();
+	for (std::vector<Edge> const &link : links)
+	{
+		nodeEdges.push_back(edges.size());
+		edges.insert(edges.end(), link.begin(), link.end());
+	}
+	nodeEdges.push_back(edges.size());
+}
+
+bool PathHierarchy::findCorridor(TileBitmap const &map_, Vector2i orig, Vector2i dest, std::vector<bool> &corridor) const
+{
+	if (orig.x < 0 || orig.y < 0 || orig.x >= width || orig.y >= height || map_.get(orig.x, orig.y) ||
+	    dest.x < 0 || dest.y < 0 || dest.x >= width || dest.y >= height || map_.get(dest.x, dest.y))
+	{
+		return false;
+	}
+	unsigned clusterO = clusterOf(orig.x, orig.y), clusterD = clusterOf(dest.x, dest.y);
+	if (abs(int(clusterO % clustersX) - int(clusterD % clustersX)) < 2 && abs(int(clusterO / clustersX) - int(clusterD / clustersX)) < 2)
+	{
+		return false;  // Close enough that searching the map directly is cheap.
+	}
+
+	// Costs from orig to the entrances of its cluster, and from the entrances of the destination cluster to dest.
+	std::vector<uint32_t> distOrig, distDest;
+	clusterDistances(map_, clusterO, orig.x + orig.y * width, distOrig);
+	clusterDistances(map_, clusterD, dest.x + dest.y * width, distDest);
+	auto localIndex = [&](unsigned cluster, uint32_t tile) {
+		int x1, y1, x2, y2;
+		clusterBounds(cluster, x1, y1, x2, y2);
+		return (tile % width - x1) + (tile / width - y1) * (x2 - x1);
+	};
+	auto estimate = [&](unsigned node) {
+		return fpathMoveCost(nodes[node] % width - dest.x, nodes[node] / width - dest.y);
+	};
+
+	// A* on the graph. The node after the last entrance is the destination.
+	unsigned goal = nodes.size();
+	std::vector<uint32_t> dist(goal + 1, NO_ROUTE);
+	std::vector<unsigned> prev(goal + 1, NO_NODE);
+	typedef std::pair<uint32_t, unsigned> Open;  // Estimated total cost, node. Ties are broken by node index, so the result is well defined.
+	std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+
+	Cluster const &co = clusters[clusterO];
+	for (unsigned i = 0; i < co.entrances.size(); ++i)
+	{
+		uint32_t d = distOrig[localIndex(clusterO, co.entrances[i])];
+		if (d != NO_ROUTE)
+		{
+			dist[co.firstNode + i] = d;
+			open.push(Open(d + estimate(co.firstNode + i), co.firstNode + i));
+		}
+	}
+
+	Cluster const &cd = clusters[clusterD];
+	while (!open.empty())
+	{
+		Open cur = open.top();
+		open.pop();
+		unsigned node = cur.second;
+		if (node == goal)
+		{
+			break;
+		}
+		if (cur.first != dist[node] + estimate(node))
+		{
+			continue;  // Already found a shorter way here.
+		}
+		if (node >= cd.firstNode && node < cd.firstNode + cd.entrances.size())
+		{
+			uint32_t d = distDest[localIndex(clusterD, nodes[node])];
+			if (d != NO_ROUTE && dist[node] + d < dist[goal])
+			{
+				dist[goal] = dist[node] + d;
+				prev[goal] = node;
+				open.push(Open(dist[goal], goal));
+			}
+		}
+		for (unsigned e = nodeEdges[node]; e < nodeEdges[node + 1]; ++e)
+		{
+			Edge const &edge = edges[e];
+			uint32_t d = dist[node] + edge.cost;
+			if (d < dist[edge.node])
+			{
+				dist[edge.node] = d;
+				prev[edge.node] = node;
+				open.push(Open(d + estimate(edge.node), edge.node));
+			}
+		}
+	}
+
+	if (dist[goal] == NO_ROUTE)
+	{
+		return false;  // No route, let the caller find the nearest reachable tile.
+	}
+
+	corridor.assign(clusters.size(), false);
+	corridor[clusterO] = true;
+	corridor[clusterD] = true;
+	for (unsigned node = prev[goal]; node != NO_NODE; node = prev[node])
+	{
+		corridor[clusterOf(nodes[node] % width, nodes[node] / width)] = true;
+	}
+	return true;
+}
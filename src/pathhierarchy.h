@@ -0,0 +1,110 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_PATHHIERARCHY_H__
+#define __INCLUDED_SRC_PATHHIERARCHY_H__
+
+#include "lib/framework/types.h"
+#include "lib/framework/vector.h"
+#include "tilebitmap.h"
+
+#include <vector>
+
+/** Abstract graph of a blocking map, for planning long routes.
+ *
+ *  The map is split into square clusters. Where two neighbouring clusters have a run of open tiles along their border, there is
+ *  a portal between them. The cost of going between the portals of a cluster is precalculated, so a route can be planned on the
+ *  portals alone, giving the clusters which a route must pass through. The precise route is then found by A* within those clusters.
+ *
+ *  The graph only depends on the contents of the blocking map, so it's the same on all clients, no matter which clusters were
+ *  reused from an earlier graph.
+ *
+ *  @ingroup pathfinding
+ */
+class PathHierarchy
+{
+public:
+	enum
+	{
+		CLUSTER_SIZE = 16,  ///< Width and height of a cluster, in tiles.
+	};
+
+	/** Builds the graph for the blocking map. If previous is not NULL, it is the graph of an earlier map of the same size, and
+	 *  changed has the tiles where map differs from that one. Only the clusters around the changes are then rebuilt.
+	 */
+	PathHierarchy(TileBitmap const &map, PathHierarchy const *previous, TileBitmap const *changed);
+
+	/// Returns the cluster containing the tile.
+	unsigned clusterOf(int x, int y) const
+	{
+		return x / CLUSTER_SIZE + y / CLUSTER_SIZE * clustersX;
+	}
+	/// Returns the cluster containing the tile, in the graph of any map which is width tiles wide.
+	static unsigned clusterOf(int x, int y, int width)
+	{
+		return x / CLUSTER_SIZE + y / CLUSTER_SIZE * ((width + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+	}
+	unsigned numClusters() const
+	{
+		return clusters.size();
+	}
+
+	/** Finds the clusters which a route from orig to dest passes through.
+	 *
+	 *  @param map The blocking map the graph was built from, or one with the same contents.
+	 *  @param corridor Set to true for each cluster the route passes through, and false for all other clusters.
+	 *  @return false if there is no route, or if orig and dest are too close together for the graph to be useful.
+	 */
+	bool findCorridor(TileBitmap const &map, Vector2i orig, Vector2i dest, std::vector<bool> &corridor) const;
+
+private:
+	struct Portal
+	{
+		uint32_t tileA, tileB;          ///< The tiles either side of the border, tileA in the left or upper cluster.
+	};
+	struct Cluster
+	{
+		std::vector<uint32_t> entrances;  ///< Tiles which are next to a portal, sorted.
+		std::vector<uint32_t> costs;      ///< Cost from each entrance to each other entrance, entrances.size()² matrix.
+		unsigned firstNode;               ///< Index in nodes of the first entrance.
+	};
+	struct Edge
+	{
+		unsigned node;
+		uint32_t cost;
+	};
+
+	void clusterBounds(unsigned cluster, int &x1, int &y1, int &x2, int &y2) const;
+	void findPortals(TileBitmap const &map, unsigned clusterA, unsigned clusterB, bool horizontal, std::vector<Portal> &portals) const;
+	void findEntrances(unsigned cluster, std::vector<uint32_t> &entrances) const;
+	void clusterDistances(TileBitmap const &map, unsigned cluster, uint32_t startTile, std::vector<uint32_t> &dist) const;
+	void findCosts(TileBitmap const &map, unsigned cluster);
+	void linkNodes();
+	unsigned nodeOf(uint32_t tile) const;
+
+	int width, height;
+	int clustersX, clustersY;
+	std::vector<Cluster> clusters;
+	std::vector<std::vector<Portal>> portalsRight;       ///< Portals between each cluster and the cluster to the right of it.
+	std::vector<std::vector<Portal>> portalsDown;        ///< Portals between each cluster and the cluster below it.
+	std::vector<uint32_t> nodes;                         ///< Tile of each node, ordered by cluster.
+	std::vector<unsigned> nodeEdges;                     ///< Index in edges of the first edge of each node, plus one past the end.
+	std::vector<Edge> edges;
+};
+
+#endif // __INCLUDED_SRC_PATHHIERARCHY_H__
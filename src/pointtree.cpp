@@ -77,24 +77,51 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
-void PointTree::insert(void *pointData, int32_t x, int32_t y)
+void PointTree::insert(Layer layer, void *pointData, int32_t x, int32_t y, uint32_t order)
 {
-	points.push_back(Point(interleave(x, y), pointData));
+	Point point;
+	point.key = interleave(x, y);
+	point.order = order;
+	point.data = pointData;
+	points[layer].push_back(point);
 }
 
-void PointTree::clear()
+void PointTree::clear(Layer layer)
 {
-	points.clear();
+	points[layer].clear();
 }
 
-static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
+void PointTree::sort(Layer layer)
 {
-	return a.first < b.first;  // Sort only by position, not by pointer address, even if two units are in the same place.
+	std::sort(points[layer].begin(), points[layer].end());  // Sort by position, then by order, even if two units are in the same place.
 }
 
-void PointTree::sort()
+void PointTree::move(Layer layer, size_t index, int32_t x, int32_t y)
 {
-	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	points[layer][index].key = interleave(x, y);
+}
+
+void PointTree::resort(Layer layer)
+{
+	// Insertion sort, since most points won't have moved past any others. Give up if it turns out to be slow.
+	Vector &v = points[layer];
+	size_t moves = 0, maxMoves = 4 * v.size() + 64;
+	for (size_t i = 1; i < v.size(); ++i)
+	{
+		Point point = v[i];
+		size_t j = i;
+		for (; j > 0 && point < v[j - 1]; --j)
+		{
+			v[j] = v[j - 1];
+		}
+		v[j] = point;
+		moves += i - j;
+		if (moves > maxMoves)
+		{
+			sort(layer);
+			break;
+		}
+	}
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -104,32 +131,7 @@ uint8_t ppm[1000][1000][3];
 int doDump = false;
 #endif //DUMP_IMAGE
 
-struct PointTreeRange
-{
-	uint64_t a, z;
-};
-
-// If !IsFiltered, function is trivially optimised to "return i;".
-template<bool IsFiltered>
-static unsigned current(std::vector<unsigned> &filterData, unsigned i)
-{
-	unsigned ret = i;
-	while (IsFiltered && filterData[ret])
-	{
-		ret += filterData[ret];
-	}
-	while (IsFiltered && filterData[i])
-	{
-		unsigned next = i + filterData[i];
-		filterData[i] = ret - i;
-		i = next;
-	}
-
-	return ret;
-}
-
-template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::findArea(Area &area, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -144,7 +146,7 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 	uint64_t splitY1 = expandY(splitYo - 1);
 	uint64_t splitY2 = expandY(splitYo);
 
-	PointTreeRange ranges[4] = {{minX    | minY,    splitX1 | splitY1},
+	Range ranges[4] = {{minX    | minY,    splitX1 | splitY1},
 		{splitX2 | minY,    maxX    | splitY1},
 		{minX    | splitY2, splitX1 | maxY},
 		{splitX2 | splitY2, maxX    | maxY}
@@ -152,10 +154,9 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 	int numRanges = 4;
 
 #ifdef DUMP_IMAGE
-	FILE *f;
 	if (doDump)
 	{
-		f = fopen("pointtree.ppm", "wb");
+		FILE *f = fopen("pointtree.ppm", "wb");
 		fprintf(f, "P6\n1000 1000\n255\n");
 		for (int py = 0; py != 1000; ++py) for (int px = 0; px != 1000; ++px)
 			{
@@ -197,6 +198,8 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 					ppm[py][px][2] /= 2;
 				}
 			}
+		fwrite(ppm[0][0], 3000000, 1, f);
+		fclose(f);
 	}
 #endif //DUMP_IMAGE
 
@@ -225,72 +228,10 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
-	if (IsFiltered)
-	{
-		lastFilteredQueryIndices.clear();
-	}
-	for (int r = 0; r != numRanges; ++r)
-	{
-		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
-		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)NULL), pointTreeSortFunction) - points.begin();
-		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)NULL), pointTreeSortFunction) - points.begin();
-
-		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
-		{
-			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
-			uint64_t py = points[i].first & 0x5555555555555555ULL;
-			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
-			{
-				lastQueryResults.push_back(points[i].second);
-				if (IsFiltered)
-				{
-					lastFilteredQueryIndices.push_back(i);
-				}
-#ifdef DUMP_IMAGE
-				if (doDump)
-				{
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][0] = 192;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][1] = 128;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][2] = 0;
-				}
-#endif //DUMP_IMAGE
-			}
-		}
-	}
-
-#ifdef DUMP_IMAGE
-	if (doDump)
-	{
-		fwrite(ppm[0][0], 3000000, 1, f);
-		fclose(f);
-	}
-#endif //DUMP_IMAGE
-
-	return lastQueryResults;
-}
-
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
-{
-	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
-}
-
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
-{
-	Filter unused;
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
-}
-
-PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
-{
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	std::copy(ranges, ranges + numRanges, area.ranges);
+	area.numRanges = numRanges;
+	area.minX = minX;
+	area.maxX = maxX;
+	area.minY = minY;
+	area.maxY = maxY;
 }
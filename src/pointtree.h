@@ -22,25 +22,43 @@
 
 #include "lib/framework/types.h"
 
+#include <algorithm>
 #include <vector>
 
+/** Points sorted by position, for finding the points in an area.
+ *
+ *  Points are kept in two layers, which are sorted separately, so that a layer with points which rarely change doesn't need to be
+ *  sorted again when the other layer changes. Query results come from both layers, ordered by position and then by the order
+ *  given when inserting, exactly as if all points were in a single layer.
+ */
 class PointTree
 {
 public:
-	typedef std::vector<void *> ResultVector;
-	typedef std::vector<unsigned> IndexVector;
+	enum Layer
+	{
+		STATIC,         ///< Points which are rarely inserted or removed, and never move.
+		DYNAMIC,        ///< Points which move all the time.
+		LAYERS
+	};
 	class Filter  ///< Filters are invalidated when modifying the PointTree.
 	{
 	public:
-		Filter() : data(1) {}  ///< Must be reset before use.
-		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1) {}
+		Filter() {}  ///< Must be reset before use.
+		Filter(PointTree const &pointTree)
+		{
+			reset(pointTree);
+		}
 		void reset(PointTree const &pointTree)
 		{
-			data.assign(pointTree.points.size() + 1, 0);
+			for (int layer = 0; layer < LAYERS; ++layer)
+			{
+				data[layer].assign(pointTree.points[layer].size() + 1, 0);
+			}
 		}
 		void erase(unsigned index)
 		{
-			data[index] = std::max(data[index], 1u);    ///< Erases the point from query results using the filter.
+			unsigned &d = data[index >> LAYER_SHIFT][index & INDEX_MASK];
+			d = std::max(d, 1u);    ///< Erases the point from query results using the filter.
 		}
 
 	private:
@@ -48,34 +66,135 @@ public:
 
 		typedef std::vector<unsigned> Data;
 
-		Data data;
+		/// Returns the first point in the layer from index i which hasn't been erased, and makes it quicker to find next time.
+		unsigned current(int layer, unsigned i)
+		{
+			Data &filterData = data[layer];
+			unsigned ret = i;
+			while (filterData[ret])
+			{
+				ret += filterData[ret];
+			}
+			while (filterData[i])
+			{
+				unsigned next = i + filterData[i];
+				filterData[i] = ret - i;
+				i = next;
+			}
+			return ret;
+		}
+
+		Data data[LAYERS];
 	};
 
-	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
-	void clear();                                                             ///< Clears the PointTree.
-	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
-	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns all objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults.
-	ResultVector &query(int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults, lastFilteredQueryIndices and the internal filter representation for faster lookups.
-	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
-	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
-
-	ResultVector lastQueryResults;
-	IndexVector lastFilteredQueryIndices;
+	/// Inserts a point into the point tree. Points in the same place are returned in ascending order, which must be unique.
+	void insert(Layer layer, void *pointData, int32_t x, int32_t y, uint32_t order);
+	void clear(Layer layer);                                                  ///< Clears a layer of the PointTree.
+	void sort(Layer layer);                                                   ///< Must be done between inserting and querying, to get meaningful results.
+	size_t size(Layer layer) const
+	{
+		return points[layer].size();
+	}
+	void *pointData(Layer layer, size_t index) const
+	{
+		return points[layer][index].data;
+	}
+	/// Moves point number index of the layer, in sorted order. Call resort() before querying.
+	void move(Layer layer, size_t index, int32_t x, int32_t y);
+	/// Sorts a layer again after moving points, which is quick if they are still almost in the same order.
+	void resort(Layer layer);
+	/** Calls visit(pointData, index) for each point which has not been filtered away, in the square minX ≤ x ≤ maxX,
+	 *  minY ≤ y ≤ maxY, sorted by position. The index can be passed to filter->erase(), to stop the point from appearing in later
+	 *  queries using the same filter. The filter may be NULL.
+	 *
+	 *  Doesn't modify the PointTree, so queries may run in several threads at once, as long as each filter is only used by one
+	 *  thread at a time.
+	 */
+	template<class Visit>
+	void query(Filter *filter, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, Visit const &visit) const;
+	/// The layer of a point, given the index passed to visit() by query().
+	static Layer indexLayer(unsigned index)
+	{
+		return Layer(index >> LAYER_SHIFT);
+	}
+	/// The number of a point within its layer, given the index passed to visit() by query().
+	static size_t indexPoint(unsigned index)
+	{
+		return index & INDEX_MASK;
+	}
 
 private:
-	typedef std::pair<uint64_t, void *> Point;
+	enum
+	{
+		LAYER_SHIFT = 31,
+		INDEX_MASK = (1u << LAYER_SHIFT) - 1
+	};
+	struct Point
+	{
+		bool operator <(Point const &b) const
+		{
+			return key != b.key ? key < b.key : order < b.order;
+		}
+
+		uint64_t key;    ///< Interleaved x and y coordinates.
+		uint32_t order;
+		void *data;
+	};
 	typedef std::vector<Point> Vector;
 
-	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	struct Range
+	{
+		uint64_t a, z;
+	};
+	/// Ranges of keys which cover a square, possibly plus some extra nearby points.
+	struct Area
+	{
+		bool contains(uint64_t key) const
+		{
+			uint64_t x = key & 0xAAAAAAAAAAAAAAAAULL;
+			uint64_t y = key & 0x5555555555555555ULL;
+			return x >= minX && x <= maxX && y >= minY && y <= maxY;
+		}
+
+		Range ranges[4];
+		int numRanges;
+		uint64_t minX, maxX, minY, maxY;
+	};
+
+	static void findArea(Area &area, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo);
 
-	Vector points;
+	Vector points[LAYERS];
 };
 
+template<class Visit>
+void PointTree::query(Filter *filter, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, Visit const &visit) const
+{
+	Area area;
+	findArea(area, minX, minY, maxX, maxY);
+	for (int r = 0; r != area.numRanges; ++r)
+	{
+		// Find range of points in each layer which may be close enough. Range is [i ... end - 1]. The order is ignored when searching.
+		unsigned i[LAYERS], end[LAYERS];
+		for (int layer = 0; layer != LAYERS; ++layer)
+		{
+			Vector const &v = points[layer];
+			unsigned i1 = std::lower_bound(v.begin(), v.end(), area.ranges[r].a, [](Point const &p, uint64_t key) { return p.key < key; }) - v.begin();
+			end[layer] = std::upper_bound(v.begin() + i1, v.end(), area.ranges[r].z, [](uint64_t key, Point const &p) { return key < p.key; }) - v.begin();
+			i[layer] = filter != NULL ? filter->current(layer, i1) : i1;
+		}
+
+		while (i[STATIC] < end[STATIC] || i[DYNAMIC] < end[DYNAMIC])
+		{
+			// Take the next point from whichever layer it comes first in, to get the same order as if there was only one layer.
+			int layer = i[DYNAMIC] >= end[DYNAMIC] || (i[STATIC] < end[STATIC] && points[STATIC][i[STATIC]] < points[DYNAMIC][i[DYNAMIC]]) ? STATIC : DYNAMIC;
+			Point const &point = points[layer][i[layer]];
+			if (area.contains(point.key))  // Only visit point if it's at least in the desired square.
+			{
+				visit(point.data, i[layer] | (unsigned)layer << LAYER_SHIFT);
+			}
+			i[layer] = filter != NULL ? filter->current(layer, i[layer] + 1) : i[layer] + 1;
+		}
+	}
+}
+
 #endif //_point_tree_h
@@ -84,6 +84,9 @@ static const UDWORD ProjectileTrackerID =	0xdead0000;
 /* The list of projectiles in play */
 static std::vector<PROJECTILE *> psProjectileList;
 
+static ObjectPool projectilePool(sizeof(PROJECTILE), "projectile");
+DEFINE_OBJECT_POOL(PROJECTILE, projectilePool)
+
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
 
@@ -109,6 +112,17 @@ struct ObjectShape
 	Vector2i size;           ///< x == y if circular.
 };
 
+/// What a projectile needs to know about an object to check whether it hits it, which doesn't change while updating projectiles.
+struct ProjectileTarget
+{
+	unsigned    iteration;   ///< The rest is only valid if equal to projectileTargetIteration.
+	Vector3i    prevPos;
+	ObjectShape shape;
+	int         height;
+};
+static std::vector<ProjectileTarget> projectileTargets;  ///< Indexed by the numbers from gridFindIndexedObjects.
+static unsigned projectileTargetIteration = 0;
+
 static ObjectShape establishTargetShape(BASE_OBJECT *psTarget);
 static void	proj_ImpactFunc(PROJECTILE *psObj);
 static void	proj_PostImpactFunc(PROJECTILE *psObj);
@@ -676,6 +690,19 @@ static int32_t collisionXYZ(Vector3i v1, Vector3i v2, ObjectShape shape, int32_t
 	return -1;
 }
 
+static ProjectileTarget const &getProjectileTarget(unsigned gridIndex, BASE_OBJECT *psObj)
+{
+	ProjectileTarget &target = projectileTargets[gridIndex];
+	if (target.iteration != projectileTargetIteration)
+	{
+		target.iteration = projectileTargetIteration;
+		target.prevPos = isDroid(psObj) ? castDroid(psObj)->prevSpacetime.pos : psObj->pos;
+		target.shape = establishTargetShape(psObj);
+		target.height = establishTargetHeight(psObj);
+	}
+	return target;
+}
+
 static void proj_InFlightFunc(PROJECTILE *psProj)
 {
 	/* we want a delay between Las-Sats firing and actually hitting in multiPlayer
@@ -800,10 +827,11 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 
 	/* Check nearby objects for possible collisions */
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	static std::vector<unsigned> gridIndices;  // static to avoid allocations.
+	gridFindIndexedObjects(gridList, gridIndices, psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
+	for (size_t i = 0; i < gridList.size(); ++i)
 	{
-		BASE_OBJECT *psTempObj = *gi;
+		BASE_OBJECT *psTempObj = gridList[i];
 		CHECK_OBJECT(psTempObj);
 
 		if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
@@ -836,13 +864,10 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 			continue;
 		}
 
-		Vector3i psTempObjPrevPos = isDroid(psTempObj) ? castDroid(psTempObj)->prevSpacetime.pos : psTempObj->pos;
-
+		ProjectileTarget const &target = getProjectileTarget(gridIndices[i], psTempObj);
 		const Vector3i diff = psProj->pos - psTempObj->pos;
-		const Vector3i prevDiff = psProj->prevSpacetime.pos - psTempObjPrevPos;
-		const unsigned int targetHeight = establishTargetHeight(psTempObj);
-		const ObjectShape targetShape = establishTargetShape(psTempObj);
-		const int32_t collision = collisionXYZ(prevDiff, diff, targetShape, targetHeight);
+		const Vector3i prevDiff = psProj->prevSpacetime.pos - target.prevPos;
+		const int32_t collision = collisionXYZ(prevDiff, diff, target.shape, target.height);
 		const uint32_t collisionTime = psProj->prevSpacetime.time + (psProj->time - psProj->prevSpacetime.time) * collision / 1024;
 
 		if (collision >= 0 && collisionTime < closestCollisionSpacetime.time)
@@ -1160,7 +1185,7 @@ static void proj_ImpactFunc(PROJECTILE *psObj)
 		psObj->born = gameTime;
 
 		static GridList gridList;  // static to avoid allocations.
-		gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, psStats->upgrade[psObj->player].radius);
+		gridFindObjects(gridList, psObj->pos.x, psObj->pos.y, psStats->upgrade[psObj->player].radius);
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psCurr = *gi;
@@ -1321,10 +1346,17 @@ void PROJECTILE::update()
 // iterate through all projectiles and update their status
 void proj_UpdateAll()
 {
-	std::vector<PROJECTILE *> psProjectileListOld = psProjectileList;
+	// Objects don't move or change shape while updating projectiles, so only work out their shapes once, when first needed.
+	++projectileTargetIteration;
+	projectileTargets.resize(gridObjectCount());
 
-	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
-	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fun(&PROJECTILE::update));
+	// Update all projectiles. Penetrating projectiles may add to psProjectileList, so go by index, and don't update the new ones
+	// until the next tick.
+	size_t numProjectiles = psProjectileList.size();
+	for (size_t i = 0; i < numProjectiles; ++i)
+	{
+		psProjectileList[i]->update();
+	}
 
 	// Remove and free dead projectiles.
 	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fun(&PROJECTILE::deleteIfDead)), psProjectileList.end());
@@ -1342,7 +1374,7 @@ static void proj_checkPeriodicalDamage(PROJECTILE *psProj)
 	WEAPON_STATS *psStats = psProj->psWStats;
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, psStats->upgrade[psProj->player].periodicalDamageRadius);
+	gridFindObjects(gridList, psProj->pos.x, psProj->pos.y, psStats->upgrade[psProj->player].periodicalDamageRadius);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psCurr = *gi;
@@ -41,6 +41,7 @@ enum PROJ_STATE
 struct PROJECTILE : public SIMPLE_OBJECT
 {
 	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player) {}
+	OBJECT_POOL_ALLOCATED;
 
 	void            update();
 	bool            deleteIfDead()
@@ -65,6 +65,7 @@
 #include "atmos.h"
 #include "warcam.h"
 #include "projectile.h"
+#include "wavecast.h"
 
 #define FAKE_REF_LASSAT 999
 #define ALL_PLAYERS -1
@@ -3578,7 +3579,7 @@ static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(4).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
+	gridFindObjects(gridList, x, y, range);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -3643,7 +3644,7 @@ static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(nextparam - 1).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateArea(x1, y1, x2, y2);
+	gridFindObjectsInArea(gridList, x1, y1, x2, y2);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -4337,6 +4338,7 @@ QScriptValue js_stats(QScriptContext *context, QScriptEngine *engine)
 			SENSOR_STATS *psStats = asSensorStats + index;
 			SCRIPT_ASSERT(context, name == "Range", "Invalid sensor parameter");
 			psStats->upgrade[player].range = value;
+			prepareWavecastTable(value);
 			dirtyAllDroids(player);
 			dirtyAllStructures(player);
 		}
@@ -3907,7 +3907,7 @@ bool scrStructureBuiltInRange(void)
 	psTarget = &asStructureStats[index];
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
+	gridFindObjects(gridList, x, y, range);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psCurr = *gi;
@@ -10036,6 +10036,7 @@ bool scrSetTileHeight(void)
 	psTile = mapTile(tileX, tileY);
 
 	psTile->height = (UBYTE)newHeight * ELEVATION_SCALE;
+	visTerrainChanged(tileX, tileY, tileX + 1, tileY + 1);
 
 	return true;
 }
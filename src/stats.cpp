@@ -38,6 +38,7 @@
 #include "lib/sound/audio_id.h"
 #include "projectile.h"
 #include "text.h"
+#include "wavecast.h"
 
 #define WEAPON_TIME		100
 
@@ -818,6 +819,7 @@ bool loadSensorStats(const char *pFileName)
 		{
 			psStats->upgrade[j].range = psStats->base.range;
 		}
+		prepareWavecastTable(psStats->base.range);
 
 		psStats->ref = REF_SENSOR_START + i;
 
@@ -1238,6 +1238,7 @@ static void buildFlatten(STRUCTURE *pStructure, int h)
 			}
 		}
 	}
+	visTerrainChanged(b.map.x, b.map.y, b.map.x + b.size.x + 1, b.map.y + b.size.y + 1);
 }
 
 static bool isPulledToTerrain(STRUCTURE const *psBuilding)
@@ -3559,10 +3560,10 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 
 	syncDebugStructure(psBuilding, '<');
 
-	if (psBuilding->flags & BASEFLAG_DIRTY)
+	if (psBuilding->flags & (BASEFLAG_DIRTY | BASEFLAG_DIRTY_VISION))
 	{
 		visTilesUpdate(psBuilding);
-		psBuilding->flags &= ~BASEFLAG_DIRTY;
+		psBuilding->flags &= ~(BASEFLAG_DIRTY | BASEFLAG_DIRTY_VISION);
 	}
 
 	if (psBuilding->pStructureType->type == REF_GATE)
@@ -3572,7 +3573,7 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 			bool		found = false;
 
 			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
+			gridFindObjects(gridList, psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
 			for (GridIterator gi = gridList.begin(); !found && gi != gridList.end(); ++gi)
 			{
 				found = isDroid(*gi);
@@ -3772,6 +3773,9 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 	CHECK_STRUCTURE(psBuilding);
 }
 
+static ObjectPool structurePool(sizeof(STRUCTURE), "structure");
+DEFINE_OBJECT_POOL(STRUCTURE, structurePool)
+
 STRUCTURE::STRUCTURE(uint32_t id, unsigned player)
 	: BASE_OBJECT(OBJ_STRUCTURE, id, player)
 	, pFunctionality(NULL)
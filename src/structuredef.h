@@ -232,6 +232,7 @@ struct STRUCTURE : public BASE_OBJECT
 {
 	STRUCTURE(uint32_t id, unsigned player);
 	~STRUCTURE();
+	OBJECT_POOL_ALLOCATED;
 
 	STRUCTURE_STATS     *pStructureType;            /* pointer to the structure stats for this type of building */
 	STRUCT_STATES       status;                     /* defines whether the structure is being built, doing nothing or performing a function */
@@ -0,0 +1,207 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_TILEBITMAP_H__
+#define __INCLUDED_SRC_TILEBITMAP_H__
+
+#include "lib/framework/types.h"
+
+#include <algorithm>
+#include <vector>
+
+/** One bit per map tile, packed into 64-bit words.
+ *
+ *  Each row starts on a new word, and unused bits at the end of a row are always 0, so rows can be scanned and compared a word at
+ *  a time.
+ */
+class TileBitmap
+{
+public:
+	TileBitmap() : width(0), height(0), stride(0) {}
+
+	/// Resizes the bitmap, and clears all bits.
+	void resize(int width_, int height_)
+	{
+		width = width_;
+		height = height_;
+		stride = (width + 63) / 64;
+		words.assign(stride * height, 0);
+	}
+	void clear()
+	{
+		std::fill(words.begin(), words.end(), 0);
+	}
+	bool empty() const
+	{
+		return words.empty();
+	}
+	bool operator ==(TileBitmap const &b) const
+	{
+		return width == b.width && height == b.height && words == b.words;
+	}
+	bool operator !=(TileBitmap const &b) const
+	{
+		return !(*this == b);
+	}
+
+	bool get(int x, int y) const
+	{
+		return (words[y * stride + x / 64] >> (x % 64)) & 1;
+	}
+	void set(int x, int y)
+	{
+		words[y * stride + x / 64] |= uint64_t(1) << (x % 64);
+	}
+	void reset(int x, int y)
+	{
+		words[y * stride + x / 64] &= ~(uint64_t(1) << (x % 64));
+	}
+	/// Returns bits x - 1, x and x + 1 of row y, as bits 0, 1 and 2. Needs 1 ≤ x < width - 1.
+	unsigned get3(int x, int y) const
+	{
+		int bit = x - 1;
+		uint64_t const *w = &words[y * stride + bit / 64];
+		uint64_t ret = w[0] >> (bit % 64);
+		if (bit % 64 > 61)
+		{
+			ret |= w[1] << (64 - bit % 64);  // Bits continue in next word.
+		}
+		return ret & 7;
+	}
+	/// Sets bits x1 ≤ x < x2 of row y.
+	void setRange(int y, int x1, int x2)
+	{
+		for (int x = std::max(x1, 0); x < std::min(x2, width); ++x)
+		{
+			set(x, y);
+		}
+	}
+
+	/// Returns whether any bit x1 ≤ x < x2, y1 ≤ y < y2 is set. The rectangle may extend outside the bitmap.
+	bool anyInRect(int x1, int y1, int x2, int y2) const
+	{
+		x1 = std::max(x1, 0);
+		y1 = std::max(y1, 0);
+		x2 = std::min(x2, width);
+		y2 = std::min(y2, height);
+		if (x1 >= x2)
+		{
+			return false;
+		}
+		int firstWord = x1 / 64, lastWord = (x2 - 1) / 64;
+		uint64_t firstMask = ~uint64_t(0) << (x1 % 64), lastMask = ~uint64_t(0) >> (63 - (x2 - 1) % 64);
+		for (int y = y1; y < y2; ++y)
+		{
+			uint64_t const *r = row(y);
+			for (int w = firstWord; w <= lastWord; ++w)
+			{
+				uint64_t mask = (w == firstWord ? firstMask : ~uint64_t(0)) & (w == lastWord ? lastMask : ~uint64_t(0));
+				if ((r[w] & mask) != 0)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	int getWidth() const
+	{
+		return width;
+	}
+	int getHeight() const
+	{
+		return height;
+	}
+	/// Number of words in each row.
+	int rowWords() const
+	{
+		return stride;
+	}
+	uint64_t *row(int y)
+	{
+		return &words[y * stride];
+	}
+	uint64_t const *row(int y) const
+	{
+		return &words[y * stride];
+	}
+
+	/** Sets row y from bytes, so bit x is set if (a[x] & maskA) | (b[x] & maskB) is nonzero. Either array may be NULL.
+	 *
+	 *  Works on 8 tiles at a time, without branching on the tile contents.
+	 */
+	void setRowFromBytes(int y, uint8_t const *a, uint8_t maskA, uint8_t const *b, uint8_t maskB)
+	{
+		uint64_t const repA = a != nullptr ? maskA * UINT64_C(0x0101010101010101) : 0;
+		uint64_t const repB = b != nullptr ? maskB * UINT64_C(0x0101010101010101) : 0;
+		uint64_t *dst = row(y);
+		for (int w = 0; w < stride; ++w)
+		{
+			uint64_t word = 0;
+			int begin = w * 64, end = std::min(begin + 64, width);
+			int x = begin;
+			for (; x + 8 <= end; x += 8)
+			{
+				uint64_t bytes = (repA != 0 ? load8(a + x) & repA : 0) | (repB != 0 ? load8(b + x) & repB : 0);
+				word |= uint64_t(nonzeroBytes(bytes)) << (x - begin);
+			}
+			for (; x < end; ++x)
+			{
+				bool bit = ((a != nullptr ? a[x] & maskA : 0) | (b != nullptr ? b[x] & maskB : 0)) != 0;
+				word |= uint64_t(bit) << (x - begin);
+			}
+			dst[w] = word;
+		}
+	}
+
+	/// Checksum of the bits, for syncDebug.
+	uint32_t checksum() const
+	{
+		uint32_t sum = 0, factor = 0;
+		for (uint64_t word : words)
+		{
+			sum ^= uint32_t(word ^ word >> 32) * (factor = 3 * factor + 1);
+		}
+		return sum;
+	}
+
+private:
+	static inline uint64_t load8(uint8_t const *bytes)
+	{
+		uint64_t ret = 0;
+		for (int i = 0; i < 8; ++i)
+		{
+			ret |= uint64_t(bytes[i]) << (i * 8);  // Compilers turn this into a single load on little-endian machines.
+		}
+		return ret;
+	}
+	/// Returns a byte with bit i set if byte i of bytes is nonzero.
+	static inline uint8_t nonzeroBytes(uint64_t bytes)
+	{
+		uint64_t const low7 = UINT64_C(0x7F7F7F7F7F7F7F7F);
+		uint64_t high = (((bytes & low7) + low7) | bytes) & ~low7;  // High bit of each byte set if the byte is nonzero.
+		return (high >> 7) * UINT64_C(0x0102040810204080) >> 56;    // Gather the high bits into one byte.
+	}
+
+	int width, height;
+	int stride;
+	std::vector<uint64_t> words;
+};
+
+#endif // __INCLUDED_SRC_TILEBITMAP_H__
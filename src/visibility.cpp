@@ -46,6 +46,7 @@
 #include "multiplay.h"
 #include "qtscript.h"
 #include "wavecast.h"
+#include "workerpool.h"
 
 // rate to change visibility level
 static const int VIS_LEVEL_INC = 255 * 2;
@@ -75,11 +76,40 @@ public:
 };
 static std::vector<SPOTTER *> apsInvisibleViewers;
 
+/// The fields of an object which processVisibility needs for every object, so the passes don't have to touch the whole object.
+struct VisibilityObject
+{
+	BASE_OBJECT *psObj;
+	Vector2i    pos;
+	int         sensorRange;
+	OBJECT_TYPE type;
+	uint8_t     player;
+	uint32_t    died;  ///< If psObj->died changes, the object was removed from its list while going through the objects.
+};
+static std::vector<VisibilityObject> visObjects;  ///< All droids, structures and features, in list order. Rebuilt every tick.
+
+/// An object which a viewer can see, found by the parallel part of the vision pass.
+struct VisionHit
+{
+	BASE_OBJECT *psObj;
+	int         val;
+};
+/// Hits of the viewers visObjects[first] to visObjects[first + VISION_TASK_SIZE - 1], and where the hits of each viewer start.
+struct VisionTask
+{
+	std::vector<VisionHit> hits;
+	std::vector<unsigned>  firstHit;  ///< One more than the number of viewers, so the hits of viewer i end at firstHit[i + 1].
+	GridList               gridList;
+};
+static const unsigned VISION_TASK_SIZE = 64;  ///< Number of viewers in each task.
+static std::vector<VisionTask> visionTasks;
+
+static bool terrainChanged = false;                   ///< Whether visTerrainChanged() was called since the last processVisibility().
+static Vector2i terrainChangedMin, terrainChangedMax;  ///< Bounds of all the tiles whose vision changed, x1 ≤ x < x2, y1 ≤ y < y2.
+
 // horrible hack because this code is full of them and I ain't rewriting it all - Per
 #define MAX_SEEN_TILES (29*29 * 355/113)  // Increased hack to support 28 tile sensor radius. - Cyp
 
-#define MIN_VIS_HEIGHT 80
-
 static int *gNumWalls = NULL;
 static Vector2i *gWall = NULL;
 
@@ -185,7 +215,7 @@ static void updateSpotters()
 			continue;
 		}
 		// else, ie if not expired, show objects around it
-		gridList = gridStartIterateUnseen(world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player);
+		gridFindUnseen(gridList, world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player);
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psObj = *gi;
@@ -210,115 +240,80 @@ SPOTTER::~SPOTTER()
 	free(watchedTiles);
 }
 
-/* Record all tiles that some object confers visibility to. Only record each tile
- * once. Note that there is both a limit to how many objects can watch any given
- * tile, and a limit to how many tiles each object can watch. Strange but non fatal
- * things will happen if these limits are exceeded. This function uses icky globals. */
-static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAPTILE *psTile, TILEPOS *recordTilePos, int *lastRecordTilePos)
+/// Returns the watcher counts of the tile, for vision of the given type (1 for close range vision, 0 for sensor vision).
+static inline uint8_t *visTileCounts(MAPTILE *psTile, TILEPOS pos)
+{
+	return pos.type != 0 ? psTile->watchers : psTile->sensors;
+}
+
+/// Makes psObj watch the tile.
+static void visAddTile(const BASE_OBJECT *psObj, MAPTILE *psTile, TILEPOS pos)
 {
 	const int rayPlayer = psObj->player;
-	const int xdiff = map_coord(psObj->pos.x) - mapX;
-	const int ydiff = map_coord(psObj->pos.y) - mapY;
-	const int distSq = xdiff * xdiff + ydiff * ydiff;
-	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
 
-	if (visionType[rayPlayer] < UBYTE_MAX && *lastRecordTilePos < MAX_SEEN_TILES)
+	visTileCounts(psTile, pos)[rayPlayer]++;        // we observe this tile
+	if (objJammerPower(psObj) > 0)                  // we are a jammer object
 	{
-		TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(inRange)};
+		psTile->jammers[rayPlayer]++;
+		psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
+	}
+	updateTileVis(psTile);
+}
 
-		visionType[rayPlayer]++;                        // we observe this tile
-		if (objJammerPower(psObj) > 0)                  // we are a jammer object
+/// Makes psObj stop watching the tile.
+static void visRemoveTile(const BASE_OBJECT *psObj, MAPTILE *psTile, TILEPOS pos)
+{
+	ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
+	uint8_t *visionType = visTileCounts(psTile, pos);
+	if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
+	{
+		return;
+	}
+	ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
+	visionType[psObj->player]--;
+	if (objJammerPower(psObj) > 0)                  // we are a jammer object
+	{
+		// No jammers in campaign, no need for special hack
+		ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+		psTile->jammers[psObj->player]--;
+		if (psTile->jammers[psObj->player] == 0)
 		{
-			psTile->jammers[rayPlayer]++;
-			psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
+			psTile->jammerBits &= ~(1 << psObj->player);
 		}
-		updateTileVis(psTile);
-		recordTilePos[*lastRecordTilePos] = tilePos;    // record having seen it
-		++*lastRecordTilePos;
 	}
+	updateTileVis(psTile);
+}
+
+/* Record a tile that some object can see, and whether it's close enough to see without a sensor. The watcher counts of the tile
+ * are updated afterwards by visTilesUpdate, which only records each tile once. Note that there is both a limit to how many objects
+ * can watch any given tile, and a limit to how many tiles each object can watch. Strange but non fatal things will happen if these
+ * limits are exceeded. */
+static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, std::vector<TILEPOS> &seenTiles)
+{
+	const int xdiff = map_coord(psObj->pos.x) - mapX;
+	const int ydiff = map_coord(psObj->pos.y) - mapY;
+	const int distSq = xdiff * xdiff + ydiff * ydiff;
+	const bool inRange = (distSq < 16);
+
+	TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(inRange)};
+	seenTiles.push_back(tilePos);
 }
 
 /* The terrain revealing ray callback */
-static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int *lastRecordTilePos)
+static void doWaveTerrain(const BASE_OBJECT *psObj, std::vector<TILEPOS> &seenTiles)
 {
-	const int sx = psObj->pos.x;
-	const int sy = psObj->pos.y;
+	static std::vector<Vector2i> visibleTiles;  // static to avoid allocations.
 	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
-	const unsigned radius = objSensorRange(psObj);
 	const int rayPlayer = psObj->player;
-	size_t size;
-	const WavecastTile *tiles = getWavecastTable(radius, &size);
-#define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
-	int heights[2][MAX_WAVECAST_LIST_SIZE];
-	int angles[2][MAX_WAVECAST_LIST_SIZE + 1];
-	int readListSize = 0, readListPos = 0, writeListPos = 0;  // readListSize, readListPos dummy initialisations.
-	int readList = 0;  // Reading from this list, writing to the other. Could also initialise to rand()%2.
-	int lastHeight = 0;  // lastHeight dummy initialisation.
-	int lastAngle = 0x7FFFFFFF;
-
-	// Start with full vision of all angles. (If someday wanting to make droids that can only look in one direction, change here, after getting the original angle values saved in the wavecast table.)
-	heights[!readList][writeListPos] = -0x7FFFFFFF - 1; // Smallest integer.
-	angles[!readList][writeListPos] = 0;               // Smallest angle.
-	++writeListPos;
-
-	for (size_t i = 0; i < size; ++i)
-	{
-		const int mapX = map_coord(sx) + tiles[i].dx;
-		const int mapY = map_coord(sy) + tiles[i].dy;
-		if (mapX < 0 || mapX >= mapWidth || mapY < 0 || mapY >= mapHeight)
-		{
-			continue;
-		}
-
-		MAPTILE *psTile = mapTile(mapX, mapY);
-		int tileHeight = std::max(psTile->height, psTile->waterLevel);  // If we can see the water surface, then let us see water-covered tiles too.
-		int perspectiveHeight = (tileHeight - sz) * tiles[i].invRadius;
-		int perspectiveHeightLeeway = (tileHeight - sz + MIN_VIS_HEIGHT) * tiles[i].invRadius;
-
-		if (tiles[i].angBegin < lastAngle)
-		{
-			// Gone around the circle. (Or just started scan.)
-			angles[!readList][writeListPos] = lastAngle;
-
-			// Flip the lists.
-			readList = !readList;
-			readListPos = 0;
-			readListSize = writeListPos;
-			writeListPos = 0;
-			lastHeight = 1;  // Impossible value since tiles[i].invRadius > 1 for all i, so triggers writing first entry in list.
-		}
-		lastAngle = tiles[i].angEnd;
 
-		while (angles[readList][readListPos + 1] <= tiles[i].angBegin && readListPos < readListSize)
-		{
-			++readListPos;  // Skip, not relevant.
-		}
+	visibleTiles.clear();
+	wavecastVisibleTiles(psMapTiles, mapWidth, mapHeight, Vector3i(psObj->pos.xy, sz), objSensorRange(psObj), visibleTiles);
 
-		bool seen = false;
-		while (angles[readList][readListPos] < tiles[i].angEnd && readListPos < readListSize)
-		{
-			int oldHeight = heights[readList][readListPos];
-			int newHeight = MAX(oldHeight, perspectiveHeight);
-			seen = seen || perspectiveHeightLeeway >= oldHeight; // consider point slightly above ground in case there is something on the tile
-			if (newHeight != lastHeight)
-			{
-				heights[!readList][writeListPos] = newHeight;
-				angles[!readList][writeListPos] = MAX(angles[readList][readListPos], tiles[i].angBegin);
-				lastHeight = newHeight;
-				++writeListPos;
-				ASSERT_OR_RETURN(, writeListPos <= MAX_WAVECAST_LIST_SIZE, "Visibility too complicated! Need to increase MAX_WAVECAST_LIST_SIZE.");
-			}
-			++readListPos;
-		}
-		--readListPos;
-
-		if (seen)
-		{
-			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
-		}
+	for (unsigned i = 0; i < visibleTiles.size(); ++i)
+	{
+		const Vector2i pos = visibleTiles[i];
+		mapTile(pos.x, pos.y)->tileExploredBits |= alliancebits[rayPlayer];  // Share exploration with allies too
+		visMarkTile(psObj, pos.x, pos.y, seenTiles);                          // Mark this tile as seen by our sensor
 	}
 }
 
@@ -331,27 +326,7 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 		{
 			const TILEPOS pos = psObj->watchedTiles[i];
 			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
-			MAPTILE *psTile = mapTile(pos.x, pos.y);
-
-			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
-			if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
-			{
-				continue;
-			}
-			ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
-			visionType[psObj->player]--;
-			if (objJammerPower(psObj) > 0)                  // we are a jammer object
-			{
-				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
-				{
-					psTile->jammerBits &= ~(1 << psObj->player);
-				}
-			}
-			updateTileVis(psTile);
+			visRemoveTile(psObj, mapTile(pos.x, pos.y), pos);
 		}
 	}
 	free(psObj->watchedTiles);
@@ -369,14 +344,14 @@ void visRemoveVisibilityOffWorld(BASE_OBJECT *psObj)
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj)
 {
+	static std::vector<TILEPOS> seenTiles;   // static to avoid allocations.
+	static std::vector<uint32_t> tileMarks;  // Which tiles psObj watched before, and which of those it still watches.
+	static uint32_t markIteration = 0;
 	TILEPOS recordTilePos[MAX_SEEN_TILES];
 	int lastRecordTilePos = 0;
 
 	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
 
-	// Remove previous map visibility provided by object
-	visRemoveVisibility(psObj);
-
 	if (psObj->type == OBJ_STRUCTURE)
 	{
 		STRUCTURE *psStruct = (STRUCTURE *)psObj;
@@ -384,14 +359,80 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 		    psStruct->pStructureType->type == REF_WALL || psStruct->pStructureType->type == REF_WALLCORNER || psStruct->pStructureType->type == REF_GATE)
 		{
 			// unbuilt structures and walls do not confer visibility.
+			visRemoveVisibility(psObj);
 			return;
 		}
 	}
+	if (!mapWidth || !mapHeight)
+	{
+		visRemoveVisibility(psObj);
+		return;
+	}
 
 	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
-	doWaveTerrain(psObj, recordTilePos, &lastRecordTilePos);
+	seenTiles.clear();
+	doWaveTerrain(psObj, seenTiles);
+
+	// Mark the tiles watched before. Most of them are still watched, and their watcher counts can be left alone, rather than
+	// removing all the previous map visibility provided by the object and adding it all again.
+	if (tileMarks.size() != (size_t)mapWidth * mapHeight || markIteration >= 0x3FFFFFFF)
+	{
+		tileMarks.assign(mapWidth * mapHeight, 0);
+		markIteration = 0;
+	}
+	++markIteration;
+	const uint32_t watchedBefore = markIteration * 4;     // Plus the type of vision.
+	const uint32_t stillWatched = markIteration * 4 + 2;
+	for (int i = 0; i < psObj->numWatchedTiles; i++)
+	{
+		const TILEPOS pos = psObj->watchedTiles[i];
+		tileMarks[pos.x + pos.y * mapWidth] = watchedBefore + pos.type;
+	}
 
 	// Record new map visibility provided by object
+	for (size_t i = 0; i < seenTiles.size() && lastRecordTilePos < MAX_SEEN_TILES; ++i)
+	{
+		const TILEPOS pos = seenTiles[i];
+		MAPTILE *psTile = mapTile(pos.x, pos.y);
+		uint32_t &mark = tileMarks[pos.x + pos.y * mapWidth];
+		uint8_t *visionType = visTileCounts(psTile, pos);
+		if (mark == watchedBefore + pos.type)
+		{
+			mark = stillWatched;
+			if (visionType[psObj->player] == 0)
+			{
+				visAddTile(psObj, psTile, pos);  // Count was already 0 when it should have been removed, see the hack in visRemoveTile.
+			}
+			else if (psTile->jammerBits != 0)
+			{
+				updateTileVis(psTile);  // Alliances may have changed since the tile was last updated.
+			}
+		}
+		else if (visionType[psObj->player] < UBYTE_MAX)
+		{
+			visAddTile(psObj, psTile, pos);
+		}
+		else
+		{
+			continue;
+		}
+		recordTilePos[lastRecordTilePos] = pos;    // record having seen it
+		++lastRecordTilePos;
+	}
+
+	// Remove map visibility of the tiles no longer watched.
+	for (int i = 0; i < psObj->numWatchedTiles; i++)
+	{
+		const TILEPOS pos = psObj->watchedTiles[i];
+		if (tileMarks[pos.x + pos.y * mapWidth] != stillWatched)
+		{
+			visRemoveTile(psObj, mapTile(pos.x, pos.y), pos);
+		}
+	}
+	free(psObj->watchedTiles);
+	psObj->watchedTiles = NULL;
+	psObj->numWatchedTiles = 0;
+
 	if (lastRecordTilePos > 0)
 	{
 		psObj->watchedTiles = (TILEPOS *)malloc(lastRecordTilePos * sizeof(*psObj->watchedTiles));
@@ -400,6 +441,58 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 	}
 }
 
+/// Whether the sensor range of psObj reaches tiles x1 ≤ x < x2, y1 ≤ y < y2.
+static bool visRangeReachesTiles(const BASE_OBJECT *psObj, int x1, int y1, int x2, int y2)
+{
+	// Distance from the object to the nearest point of the rectangle, in world coordinates.
+	int dx = std::max(std::max(world_coord(x1) - psObj->pos.x, psObj->pos.x - world_coord(x2)), 0);
+	int dy = std::max(std::max(world_coord(y1) - psObj->pos.y, psObj->pos.y - world_coord(y2)), 0);
+	int range = objSensorRange(psObj) + TILE_UNITS;  // Vision of the tile beyond the range depends on the tile before it.
+	return dx < range && dy < range && iHypot(dx, dy) < range;
+}
+
+void visTerrainChanged(int x1, int y1, int x2, int y2)
+{
+	// A tile's vision depends on the heights of its corners, so tiles either side of a changed corner are affected.
+	Vector2i changedMin(x1 - 1, y1 - 1), changedMax(x2 + 1, y2 + 1);
+	if (terrainChanged)
+	{
+		changedMin = Vector2i(std::min(changedMin.x, terrainChangedMin.x), std::min(changedMin.y, terrainChangedMin.y));
+		changedMax = Vector2i(std::max(changedMax.x, terrainChangedMax.x), std::max(changedMax.y, terrainChangedMax.y));
+	}
+	terrainChanged = true;
+	terrainChangedMin = changedMin;
+	terrainChangedMax = changedMax;
+}
+
+/// Marks the droids and structures which could see the terrain changed since the last call, once for all the changes.
+static void processTerrainChanged()
+{
+	if (!terrainChanged)
+	{
+		return;
+	}
+	terrainChanged = false;
+	int x1 = terrainChangedMin.x, y1 = terrainChangedMin.y, x2 = terrainChangedMax.x, y2 = terrainChangedMax.y;
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if (psDroid->numWatchedTiles > 0 && visRangeReachesTiles(psDroid, x1, y1, x2, y2))
+			{
+				psDroid->flags |= BASEFLAG_DIRTY_VISION;
+			}
+		}
+		for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != NULL; psStruct = psStruct->psNext)
+		{
+			if (psStruct->numWatchedTiles > 0 && visRangeReachesTiles(psStruct, x1, y1, x2, y2))
+			{
+				psStruct->flags |= BASEFLAG_DIRTY_VISION;
+			}
+		}
+	}
+}
+
 /*reveals all the terrain in the map*/
 void revealAll(UBYTE player)
 {
@@ -592,22 +685,20 @@ static void setSeenByInstantly(BASE_OBJECT *psObj, unsigned viewer, int val /*=
 }
 
 // Calculate which objects we should know about based on alliances and satellite view.
-static void processVisibilitySelf(BASE_OBJECT *psObj)
+static void processVisibilitySelf(VisibilityObject const &obj, unsigned const *allSeeingViewers, unsigned numAllSeeingViewers)
 {
-	if (psObj->type != OBJ_FEATURE && objSensorRange(psObj) > 0)
+	BASE_OBJECT *psObj = obj.psObj;
+	if (obj.type != OBJ_FEATURE && obj.sensorRange > 0)
 	{
 		// one can trivially see oneself
-		setSeenBy(psObj, psObj->player, UBYTE_MAX);
+		setSeenBy(psObj, obj.player, UBYTE_MAX);
 	}
 
 	// if a player has a SAT_UPLINK structure, or has godMode enabled,
 	// they can see everything!
-	for (unsigned viewer = 0; viewer < MAX_PLAYERS; viewer++)
+	for (unsigned i = 0; i < numAllSeeingViewers; ++i)
 	{
-		if (getSatUplinkExists(viewer) || (viewer == selectedPlayer && godMode))
-		{
-			setSeenBy(psObj, viewer, UBYTE_MAX);
-		}
+		setSeenBy(psObj, allSeeingViewers[i], UBYTE_MAX);
 	}
 
 	psObj->flags &= ~BASEFLAG_TARGETED;	// Remove any targetting locks from last update.
@@ -630,39 +721,65 @@ static void processVisibilitySelf(BASE_OBJECT *psObj)
 	}
 }
 
-// Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
-static void processVisibilityVision(BASE_OBJECT *psViewer)
+// Find which objects a viewer can see, without changing anything, so it can run on any thread.
+static void findVisionHits(VisibilityObject const &viewer, GridList &gridList, std::vector<VisionHit> &hits)
 {
-	if (psViewer->type == OBJ_FEATURE)
+	if (viewer.type == OBJ_FEATURE)
 	{
 		return;
 	}
 
-	// get all the objects from the grid the droid is in
-	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
+	// Objects already fully seen by the viewer's player this tick are skipped, same as by gridFindUnseen. More objects can become
+	// fully seen while the hits are committed, so that's checked again in processVisibilityVision.
+	gridFindObjects(gridList, viewer.pos.x, viewer.pos.y, viewer.sensorRange);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
+		if (psObj->seenThisTick[viewer.player] == UINT8_MAX)
+		{
+			continue;
+		}
 
-		int val = visibleObject(psViewer, psObj, false);
-
-		// If we've got ranged line of sight...
+		int val = visibleObject(viewer.psObj, psObj, false);
 		if (val > 0)
 		{
-			// Tell system that this side can see this object
-			setSeenBy(psObj, psViewer->player, val);
+			VisionHit hit = {psObj, val};
+			hits.push_back(hit);
+		}
+	}
+}
+
+// Tell the system about the objects the viewer can see. Must be called in the order of the viewers.
+static void processVisibilityVision(VisibilityObject const &viewer, VisionHit const *hits, VisionHit const *hitsEnd)
+{
+	BASE_OBJECT *psViewer = viewer.psObj;
+	if (viewer.type == OBJ_FEATURE || psViewer->died != viewer.died)
+	{
+		return;  // Features can't see, and scripts called by triggerEventSeen may have destroyed the viewer.
+	}
 
-			// Check if scripting system wants to trigger an event for this
-			triggerEventSeen(psViewer, psObj);
+	for (VisionHit const *hit = hits; hit != hitsEnd; ++hit)
+	{
+		BASE_OBJECT *psObj = hit->psObj;
+		int val = hit->val;
 
-			// This looks like some kind of weird hack. Only used by wzscript.
-			if (psObj->type != OBJ_FEATURE && psObj->visible[psViewer->player] <= 0)
-			{
-				// features are not in the cluster system
-				clustObjectSeen(psObj, psViewer);
-			}
+		// Seen by an earlier viewer, so gridFindUnseen wouldn't have found it.
+		if (psObj->seenThisTick[viewer.player] == UINT8_MAX)
+		{
+			continue;
+		}
+
+		// Tell system that this side can see this object
+		setSeenBy(psObj, psViewer->player, val);
+
+		// Check if scripting system wants to trigger an event for this
+		triggerEventSeen(psViewer, psObj);
+
+		// This looks like some kind of weird hack. Only used by wzscript.
+		if (psObj->type != OBJ_FEATURE && psObj->visible[psViewer->player] <= 0)
+		{
+			// features are not in the cluster system
+			clustObjectSeen(psObj, psViewer);
 		}
 	}
 }
@@ -745,9 +862,71 @@ static void processVisibilityLevel(BASE_OBJECT *psObj)
 	}
 }
 
+/// An active radar, which radar detectors can see from far away.
+struct RadarTarget
+{
+	BASE_OBJECT *psObj;
+	Vector2i    pos;
+};
+
+/// Shows active radars within ten times the sensor range of radar detectors as radar blips.
+static void processVisibilityRadarDetectors()
+{
+	static std::vector<BASE_OBJECT *> detectors;  // static to avoid allocations.
+	static std::vector<RadarTarget> radarTargets;
+
+	detectors.clear();
+	radarTargets.clear();
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	{
+		if (objRadarDetector(psObj))
+		{
+			detectors.push_back(psObj);
+		}
+	}
+	if (detectors.empty())
+	{
+		return;
+	}
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	{
+		if (objActiveRadar(psObj))
+		{
+			RadarTarget target = {psObj, psObj->pos.xy};
+			radarTargets.push_back(target);
+		}
+	}
+
+	// Sorted by x, so each detector only looks at the targets within its range horizontally. Which order the targets are marked
+	// in doesn't matter, since they are all marked the same.
+	auto byX = [](RadarTarget const &a, RadarTarget const &b) { return a.pos.x < b.pos.x; };
+	std::sort(radarTargets.begin(), radarTargets.end(), byX);
+	for (BASE_OBJECT *psObj : detectors)
+	{
+		const int range = objSensorRange(psObj) * 10;
+		const Vector2i pos = psObj->pos.xy;
+		RadarTarget bound = {NULL, Vector2i(pos.x - range, 0)};
+		auto target = std::upper_bound(radarTargets.begin(), radarTargets.end(), bound, byX);
+		for (; target != radarTargets.end() && target->pos.x < pos.x + range; ++target)
+		{
+			BASE_OBJECT *psTarget = target->psObj;
+			const int64_t dx = target->pos.x - pos.x, dy = target->pos.y - pos.y;
+			if (psTarget != psObj && psTarget->visible[psObj->player] < UBYTE_MAX / 2
+			    && dx * dx + dy * dy < (int64_t)range * range)  // Same as iHypot(dx, dy) < range, since iHypot rounds down.
+			{
+				psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+			}
+		}
+	}
+}
+
 void processVisibility()
 {
 	updateSpotters();
+	processTerrainChanged();
+
+	// Copy the fields needed by the self and vision passes into one array, instead of going through the lists twice.
+	visObjects.clear();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
@@ -756,37 +935,54 @@ void processVisibility()
 		{
 			for (BASE_OBJECT *psObj = lists[list]; psObj != NULL; psObj = psObj->psNext)
 			{
-				processVisibilitySelf(psObj);
+				VisibilityObject obj = {psObj, psObj->pos.xy, objSensorRange(psObj), psObj->type, psObj->player, psObj->died};
+				visObjects.push_back(obj);
 			}
 		}
 	}
-	for (int player = 0; player < MAX_PLAYERS; ++player)
+
+	unsigned allSeeingViewers[MAX_PLAYERS];
+	unsigned numAllSeeingViewers = 0;
+	for (unsigned viewer = 0; viewer < MAX_PLAYERS; viewer++)
 	{
-		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
-		unsigned list;
-		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
+		if (getSatUplinkExists(viewer) || (viewer == selectedPlayer && godMode))
 		{
-			for (BASE_OBJECT *psObj = lists[list]; psObj != NULL; psObj = psObj->psNext)
-			{
-				processVisibilityVision(psObj);
-			}
+			allSeeingViewers[numAllSeeingViewers++] = viewer;
 		}
 	}
-	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	for (VisibilityObject const &obj : visObjects)
 	{
-		if (objRadarDetector(psObj))
+		processVisibilitySelf(obj, allSeeingViewers, numAllSeeingViewers);
+	}
+
+	// Find what each viewer can see on the worker threads, then commit the results in the same order as going through the droid
+	// and structure lists of each player, so the game state and script events are the same as when done serially.
+	unsigned numTasks = (visObjects.size() + VISION_TASK_SIZE - 1) / VISION_TASK_SIZE;
+	if (visionTasks.size() < numTasks)
+	{
+		visionTasks.resize(numTasks);
+	}
+	workerPoolRun(numTasks, [](unsigned n)
+	{
+		VisionTask &task = visionTasks[n];
+		task.hits.clear();
+		task.firstHit.clear();
+		unsigned end = std::min<unsigned>((n + 1) * VISION_TASK_SIZE, visObjects.size());
+		for (unsigned i = n * VISION_TASK_SIZE; i < end; ++i)
 		{
-			for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != NULL; psTarget = psTarget->psNextFunc)
-			{
-				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
-				    && objActiveRadar(psTarget)
-				    && iHypot((psTarget->pos - psObj->pos).xy) < objSensorRange(psObj) * 10)
-				{
-					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
-				}
-			}
+			task.firstHit.push_back(task.hits.size());
+			findVisionHits(visObjects[i], task.gridList, task.hits);
 		}
+		task.firstHit.push_back(task.hits.size());
+	});
+	for (unsigned i = 0; i < visObjects.size(); ++i)
+	{
+		VisionTask const &task = visionTasks[i / VISION_TASK_SIZE];
+		unsigned j = i % VISION_TASK_SIZE;
+		VisionHit const *hits = task.hits.data();
+		processVisibilityVision(visObjects[i], hits + task.firstHit[j], hits + task.firstHit[j + 1]);
 	}
+	processVisibilityRadarDetectors();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
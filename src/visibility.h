@@ -33,6 +33,14 @@ extern bool visInitialise(void);
 /* Check which tiles can be seen by an object */
 extern void visTilesUpdate(BASE_OBJECT *psObj);
 
+/** Marks droids and structures which can see the map tile corners x1 ≤ x < x2, y1 ≤ y < y2, so they recalculate which tiles
+ *  they can see on their next update, after the heights of those tile corners have changed.
+ *
+ *  The changes are collected and the objects are only marked once, in the next processVisibility(), so placing many structures
+ *  at once, such as when loading a map, doesn't go through all the objects for each one.
+ */
+void visTerrainChanged(int x1, int y1, int x2, int y2);
+
 extern void revealAll(UBYTE player);
 
 /* Check whether psViewer can see psTarget
@@ -60,6 +60,7 @@ struct WARZONE_GLOBALS
 	bool		pauseOnFocusLoss;
 	bool		ColouredCursor;
 	bool		MusicEnabled;
+	int		workerThreads;
 };
 
 /***************************************************************************/
@@ -92,6 +93,7 @@ void war_SetDefaultStates(void)//Sets all states
 	war_SetMusicEnabled(true);
 	war_SetSPcolor(0);		//default color is green
 	war_setMPcolour(-1);            // Default color is random.
+	war_SetWorkerThreads(0);        // Default is one per CPU core.
 }
 
 void war_SetSPcolor(int color)
@@ -252,3 +254,13 @@ void war_SetMusicEnabled(bool enabled)
 {
 	warGlobs.MusicEnabled = enabled;
 }
+
+void war_SetWorkerThreads(int threads)
+{
+	warGlobs.workerThreads = std::max(threads, 0);
+}
+
+int war_GetWorkerThreads()
+{
+	return warGlobs.workerThreads;
+}
@@ -101,4 +101,19 @@ void war_setSoundEnabled(bool soundEnabled);
  */
 bool war_getSoundEnabled(void);
 
+/**
+ * Set the number of worker threads used for background game calculations, such as pathfinding
+ * Has no effect after fpathInitialise()!
+ *
+ * \param	threads	number of threads, or 0 to choose from the number of CPU cores
+ */
+void war_SetWorkerThreads(int threads);
+
+/**
+ * Number of worker threads to use for background game calculations
+ *
+ * \return	Configured number of threads, or 0 if it should be chosen automatically
+ */
+int war_GetWorkerThreads();
+
 #endif // __INCLUDED_SRC_WARZONECONFIG_H__
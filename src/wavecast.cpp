@@ -150,18 +150,122 @@ static std::vector<WavecastTile> generateWavecastTable(unsigned radius)
 	return tiles;
 }
 
-// Not thread safe if someone calls with a new radius. Thread safe, otherwise.
-const WavecastTile *getWavecastTable(unsigned radius, size_t *size)
-{
-	static std::map<unsigned, std::vector<WavecastTile> > tables;
+static std::map<unsigned, std::vector<WavecastTile> > wavecastTables;
 
-	std::vector<WavecastTile> &table = tables[radius];
+void prepareWavecastTable(unsigned radius)
+{
+	std::vector<WavecastTile> &table = wavecastTables[radius];
 	if (table.empty())
 	{
 		// Table not generated yet.
 		generateWavecastTable(radius).swap(table);
 	}
+}
+
+// Not thread safe if someone calls with a new radius. Thread safe, otherwise.
+const WavecastTile *getWavecastTable(unsigned radius, size_t *size)
+{
+	std::map<unsigned, std::vector<WavecastTile> >::const_iterator i = wavecastTables.find(radius);
+	if (i == wavecastTables.end())
+	{
+		// Radius not known in advance, such as the radius of a spotter added by a script.
+		prepareWavecastTable(radius);
+		i = wavecastTables.find(radius);
+	}
+
+	*size = i->second.size();
+	return &i->second[0];
+}
+
+#define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
+
+// Goes around the tiles of the table in rings, keeping a list of the highest perspective height seen so far at each angle, as
+// runs of angles with the same height. Each ring reads the list made by the previous ring and writes a new one.
+//
+// The inner loops don't branch on the heights. An entry is always written to the new list, but only kept if the height changed,
+// and a tile is always written to seenTiles, but only kept if seen. The lists end with the end angle of the list, and then a
+// sentinel which no tile can reach, so the loops don't need to check the list size.
+void wavecastVisibleTiles(MAPTILE const *mapTiles, int width, int height, Vector3i viewer, unsigned radius, std::vector<Vector2i> &seenTiles)
+{
+	size_t size;
+	const WavecastTile *tiles = getWavecastTable(radius, &size);
+	int heights[2][MAX_WAVECAST_LIST_SIZE + 1];
+	int angles[2][MAX_WAVECAST_LIST_SIZE + 2];
+	int *readHeights = heights[0], *readAngles = angles[0];
+	int *writeHeights = heights[1], *writeAngles = angles[1];
+	int readListSize = 0, readListPos = 0, writeListPos = 0;  // readListSize, readListPos dummy initialisations.
+	int lastHeight = 0;  // lastHeight dummy initialisation.
+	int lastAngle = 0x7FFFFFFF;
+	const int centreX = map_coord(viewer.x), centreY = map_coord(viewer.y);
+
+	size_t numSeen = seenTiles.size();
+	seenTiles.resize(numSeen + size);
+	Vector2i *seenOut = seenTiles.data();
+
+	// Start with full vision of all angles. (If someday wanting to make droids that can only look in one direction, change here, after getting the original angle values saved in the wavecast table.)
+	writeHeights[writeListPos] = -0x7FFFFFFF - 1; // Smallest integer.
+	writeAngles[writeListPos] = 0;                // Smallest angle.
+	++writeListPos;
 
-	*size = table.size();
-	return &table[0];
+	for (size_t i = 0; i < size; ++i)
+	{
+		const int mapX = centreX + tiles[i].dx;
+		const int mapY = centreY + tiles[i].dy;
+		if (mapX < 0 || mapX >= width || mapY < 0 || mapY >= height)
+		{
+			continue;
+		}
+
+		MAPTILE const *psTile = &mapTiles[mapX + mapY * width];
+		const int tileHeight = std::max(psTile->height, psTile->waterLevel);  // If we can see the water surface, then let us see water-covered tiles too.
+		const int perspectiveHeight = (tileHeight - viewer.z) * tiles[i].invRadius;
+		const int perspectiveHeightLeeway = (tileHeight - viewer.z + MIN_VIS_HEIGHT) * tiles[i].invRadius;
+		const int angBegin = tiles[i].angBegin, angEnd = tiles[i].angEnd;
+
+		if (angBegin < lastAngle)
+		{
+			// Gone around the circle. (Or just started scan.)
+			writeAngles[writeListPos] = lastAngle;
+			writeAngles[writeListPos + 1] = 0x7FFFFFFF;
+
+			// Flip the lists.
+			std::swap(readHeights, writeHeights);
+			std::swap(readAngles, writeAngles);
+			readListPos = 0;
+			readListSize = writeListPos;
+			writeListPos = 0;
+			lastHeight = 1;  // Impossible value since tiles[i].invRadius > 1 for all i, so triggers writing first entry in list.
+		}
+		lastAngle = angEnd;
+
+		while (readAngles[readListPos + 1] <= angBegin)
+		{
+			++readListPos;  // Skip, not relevant.
+		}
+
+		bool seen = false;
+		const int readEnd = std::min(angEnd, readAngles[readListSize]);
+		while (readAngles[readListPos] < readEnd)
+		{
+			const int oldHeight = readHeights[readListPos];
+			const int newHeight = std::max(oldHeight, perspectiveHeight);
+			seen |= perspectiveHeightLeeway >= oldHeight;  // consider point slightly above ground in case there is something on the tile
+			writeHeights[writeListPos] = newHeight;
+			writeAngles[writeListPos] = std::max(readAngles[readListPos], angBegin);
+			writeListPos += newHeight != lastHeight;
+			lastHeight = newHeight;
+			if (writeListPos > MAX_WAVECAST_LIST_SIZE)
+			{
+				ASSERT(false, "Visibility too complicated! Need to increase MAX_WAVECAST_LIST_SIZE.");
+				seenTiles.resize(numSeen);
+				return;
+			}
+			++readListPos;
+		}
+		--readListPos;
+
+		seenOut[numSeen] = Vector2i(mapX, mapY);
+		numSeen += seen;
+	}
+	seenTiles.resize(numSeen);
 }
@@ -20,6 +20,14 @@
 #ifndef _WAVE_CAST_H_
 #define _WAVE_CAST_H_
 
+#include "lib/framework/vector.h"
+
+#include <vector>
+
+struct MAPTILE;
+
+#define MIN_VIS_HEIGHT 80  ///< Height above the ground of the lowest viewer, and how far above a tile a viewer can see something on it.
+
 struct WavecastTile
 {
 	int16_t dx, dy;            ///< Tile coordinates.
@@ -28,7 +36,19 @@ struct WavecastTile
 };
 
 
+/// Generates the table for the radius, if not generated already. Called when a sensor range is loaded or upgraded, so that the
+/// table is ready before any object uses it, instead of being generated during the game.
+void prepareWavecastTable(unsigned radius);
+
 // Not thread safe if someone calls with a new radius. Thread safe, otherwise.
 const WavecastTile *getWavecastTable(unsigned radius, size_t *size);
 
+/** Finds the tiles which a viewer can see within radius, where the terrain doesn't hide them.
+ *
+ *  @param mapTiles The map, width × height tiles.
+ *  @param viewer Position of the viewer's eyes, in world coordinates.
+ *  @param seenTiles The tiles seen are added to the end, in the order of the wavecast table.
+ */
+void wavecastVisibleTiles(MAPTILE const *mapTiles, int width, int height, Vector3i viewer, unsigned radius, std::vector<Vector2i> &seenTiles);
+
 #endif //_WAVE_CAST_H_
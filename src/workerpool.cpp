@@ -0,0 +1,159 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Pool of threads for splitting up work within a game tick.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+
+#include "workerpool.h"
+#include "warzoneconfig.h"
+
+#include <algorithm>
+#include <vector>
+
+static std::vector<WZ_THREAD *> workerThreads;
+static WZ_MUTEX *workerMutex = nullptr;
+static WZ_SEMAPHORE *workerSemaphore = nullptr;  ///< Posted once per worker thread, when there are tasks or the threads should quit.
+static WZ_SEMAPHORE *workerDoneSemaphore = nullptr;  ///< Posted when the last task of a run has finished.
+static bool workerQuit = false;
+
+// The current run. Protected by workerMutex.
+static std::function<void (unsigned)> const *workerTask = nullptr;
+static unsigned workerNumTasks = 0;
+static unsigned workerNextTask = 0;
+static unsigned workerTasksDone = 0;
+
+/// Runs tasks until there are none left to start. Call with workerMutex locked.
+static void workerRunTasks()
+{
+	while (workerTask != nullptr && workerNextTask < workerNumTasks)
+	{
+		std::function<void (unsigned)> const &task = *workerTask;
+		unsigned n = workerNextTask++;
+
+		wzMutexUnlock(workerMutex);
+		task(n);
+		wzMutexLock(workerMutex);
+
+		if (++workerTasksDone == workerNumTasks)
+		{
+			workerTask = nullptr;
+			wzSemaphorePost(workerDoneSemaphore);
+		}
+	}
+}
+
+/** This runs in separate threads */
+static int workerThreadFunc(void *)
+{
+	wzMutexLock(workerMutex);
+	while (!workerQuit)
+	{
+		workerRunTasks();
+
+		wzMutexUnlock(workerMutex);
+		wzSemaphoreWait(workerSemaphore);  // Go to sleep until needed.
+		wzMutexLock(workerMutex);
+	}
+	wzMutexUnlock(workerMutex);
+	return 0;
+}
+
+static void workerPoolStart()
+{
+	workerMutex = wzMutexCreate();
+	workerSemaphore = wzSemaphoreCreate(0);
+	workerDoneSemaphore = wzSemaphoreCreate(0);
+	workerQuit = false;
+
+	// The calling thread also runs tasks, so leave it a core.
+	int numThreads = war_GetWorkerThreads() > 0 ? war_GetWorkerThreads() : wzGetCpuCount() - 1;
+	numThreads = std::max(numThreads, 0);
+	debug(LOG_INFO, "Using %d worker threads.", numThreads);
+	for (int i = 0; i < numThreads; ++i)
+	{
+		WZ_THREAD *thread = wzThreadCreate(workerThreadFunc, NULL);
+		wzThreadStart(thread);
+		workerThreads.push_back(thread);
+	}
+}
+
+void workerPoolRun(unsigned numTasks, std::function<void (unsigned task)> const &task)
+{
+	if (numTasks == 0)
+	{
+		return;
+	}
+	if (workerMutex == nullptr)
+	{
+		workerPoolStart();
+	}
+	if (numTasks == 1 || workerThreads.empty())
+	{
+		for (unsigned n = 0; n < numTasks; ++n)
+		{
+			task(n);
+		}
+		return;
+	}
+
+	wzMutexLock(workerMutex);
+	ASSERT(workerTask == nullptr, "workerPoolRun called from within a task");
+	workerTask = &task;
+	workerNumTasks = numTasks;
+	workerNextTask = 0;
+	workerTasksDone = 0;
+	for (unsigned i = 0; i < std::min<size_t>(workerThreads.size(), numTasks - 1); ++i)
+	{
+		wzSemaphorePost(workerSemaphore);  // Wake up threads.
+	}
+	workerRunTasks();
+	wzMutexUnlock(workerMutex);
+
+	wzSemaphoreWait(workerDoneSemaphore);  // Wait for tasks still running on other threads.
+}
+
+void workerPoolShutdown()
+{
+	if (workerMutex == nullptr)
+	{
+		return;
+	}
+
+	wzMutexLock(workerMutex);
+	workerQuit = true;
+	wzMutexUnlock(workerMutex);
+	for (unsigned i = 0; i < workerThreads.size(); ++i)
+	{
+		wzSemaphorePost(workerSemaphore);  // Wake up threads.
+	}
+	for (WZ_THREAD *thread : workerThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	workerThreads.clear();
+	wzMutexDestroy(workerMutex);
+	workerMutex = nullptr;
+	wzSemaphoreDestroy(workerSemaphore);
+	workerSemaphore = nullptr;
+	wzSemaphoreDestroy(workerDoneSemaphore);
+	workerDoneSemaphore = nullptr;
+}
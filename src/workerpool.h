@@ -0,0 +1,37 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2015  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+#ifndef __INCLUDED_SRC_WORKERPOOL_H__
+#define __INCLUDED_SRC_WORKERPOOL_H__
+
+#include <functional>
+
+/** Runs task(0) to task(numTasks - 1) on the worker threads and the calling thread, and returns when all have finished.
+ *
+ *  Tasks may run in any order, at the same time, so the results must not depend on which thread ran which task. To keep the
+ *  game state the same on all clients, tasks should only write to memory owned by the task, and the results should be merged
+ *  afterwards, in task order.
+ *
+ *  Must only be called from the main thread, and not from within a task.
+ */
+void workerPoolRun(unsigned numTasks, std::function<void (unsigned task)> const &task);
+
+/// Stops the worker threads. They are started again by the next workerPoolRun.
+void workerPoolShutdown();
+
+#endif // __INCLUDED_SRC_WORKERPOOL_H__
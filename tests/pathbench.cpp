@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+#include "map/mapload.h"
+#include "pathbench.h"
+
+// Same values as in src/map.h.
+#define FEATURE_BLOCKED		0x02
+#define WATER_BLOCKED		0x04
+#define LAND_BLOCKED		0x08
+
+/// Same as the blocking bits given by mapTerrainBlocking() in src/map.h, without features or structures.
+static void terrainBlockBits(GAMEMAP *map, std::vector<uint8_t> &blockBits)
+{
+	blockBits.resize(map->width * map->height);
+	for (unsigned y = 0; y < map->height; ++y)
+	{
+		for (unsigned x = 0; x < map->width; ++x)
+		{
+			MAPTILE *psTile = mapTile(map, x, y);
+			uint8_t &bits = blockBits[x + y * map->width];
+			bits = terrainType(psTile) == TER_WATER ? WATER_BLOCKED : LAND_BLOCKED;
+			if (terrainType(psTile) == TER_CLIFFFACE)
+			{
+				bits |= FEATURE_BLOCKED;
+			}
+		}
+	}
+}
+
+/// Replays a trace recorded with "warzone2100 --pathtrace=<file>", which writes each game to <file>.1, <file>.2 and so on in the
+/// configuration directory, on the map it was recorded on, such as "mp/multiplay/maps/4c-rush".
+static int replayTrace(const char *traceName, char *mapName)
+{
+	GAMEMAP *map = mapLoad(mapName);
+	if (!map)
+	{
+		fprintf(stderr, "pathbench: Failed to load \"%s\"\n", mapName);
+		return -1;
+	}
+	std::vector<uint8_t> blockBits;
+	terrainBlockBits(map, blockBits);
+	bool ok = pathBenchTrace(traceName, map->width, map->height, &blockBits[0]);
+	mapFree(map);
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	char datapath[PATH_MAX];
+	bool ok = true;
+
+	PHYSFS_init(argv[0]);
+	strcpy(datapath, getenv("srcdir") != NULL ? getenv("srcdir") : ".");
+	strcat(datapath, "/../data");
+	PHYSFS_addToSearchPath(datapath, 1);
+
+	// Without arguments, as run by make check, only find enough routes to check the results.
+	bool bench = argc == 2 && strcmp(argv[1], "--bench") == 0;
+	if (argc == 4 && strcmp(argv[1], "--trace") == 0)
+	{
+		return replayTrace(argv[2], argv[3]);
+	}
+	else if (argc != 1 && !bench)
+	{
+		fprintf(stderr, "Usage: %s [--bench | --trace <trace file> <map directory>]\n", argv[0]);
+		return -1;
+	}
+
+	FILE *fp = fopen("maplist.txt", "r");
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Failed to open list file\n", argv[0]);
+		return -1;
+	}
+
+	while (!feof(fp))
+	{
+		GAMEMAP *map;
+		char filename[PATH_MAX], *delim;
+
+		if (fscanf(fp, "%254s\n", filename) != 1)
+		{
+			fprintf(stderr, "pathbench: Couldn't fscanf maplist.txt.\n");
+			return -1;
+		}
+
+		// Only skirmish maps, campaign maps are split up by scroll limits.
+		if (strncmp(filename, "mp/", 3) != 0)
+		{
+			continue;
+		}
+
+		// Strip "/game.map"
+		delim = strrchr(filename, '/');
+		if (!delim)
+		{
+			fprintf(stderr, "pathbench: Failed to find map directory for \"%s\"\n", filename);
+			return -1;
+		}
+		*delim = '\0';
+
+		map = mapLoad(filename);
+		if (!map)
+		{
+			fprintf(stderr, "pathbench: Failed to load \"%s\"\n", filename);
+			return -1;
+		}
+
+		std::vector<uint8_t> blockBits;
+		terrainBlockBits(map, blockBits);
+		ok = pathBenchMap(filename, map->width, map->height, &blockBits[0], bench) && ok;
+		mapFree(map);
+	}
+	fclose(fp);
+
+	pathBenchSummary();
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#ifndef __INCLUDED_TESTS_PATHBENCH_H__
+#define __INCLUDED_TESTS_PATHBENCH_H__
+
+#include <stdint.h>
+
+// Kept apart from the map loader, since tools/map/mapload.h and src/map.h define the same names.
+
+/// Finds routes on a map with both Jump Point Search and A*, where blockBits are the *_BLOCKED bits of each tile. Returns false if they disagree.
+/// Only finds a few routes unless bench is set.
+bool pathBenchMap(const char *name, int width, int height, const uint8_t *blockBits, bool bench);
+
+/// Prints the totals for all maps.
+void pathBenchSummary();
+
+/// Replays the path jobs recorded with --pathtrace on a map, where blockBits are the terrain *_BLOCKED bits of each tile. Returns false if the trace can't be read.
+bool pathBenchTrace(const char *traceName, int width, int height, const uint8_t *blockBits);
+
+#endif // __INCLUDED_TESTS_PATHBENCH_H__
@@ -0,0 +1,364 @@
+/*
+ * Pathfinding benchmark, the part which uses the game headers.
+ *
+ * Finds the same random routes with FMT_MOVE, which uses Jump Point Search, and with FMT_BLOCK, which uses A*. Without
+ * structures on the map, both move types have the same blocking map, so both should find a route to the same destinations.
+ *
+ * Can also replay the jobs recorded in a real game, see FPATH_TRACE_RECORD.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/crc.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/netplay/netplay.h"
+#include "src/astar.h"
+#include "src/fpath.h"
+#include "src/fpathlane.h"
+#include "src/map.h"
+#include "src/multiplay.h"
+#include "pathbench.h"
+
+#include <chrono>
+#include <new>
+#include <vector>
+
+#define BENCH_ROUTES	200	///< Number of routes to find on each map, when benchmarking.
+#define CHECK_ROUTES	20	///< Number of routes to find on each map, when only checking that both searches agree.
+
+// Globals used by astar.cpp.
+SDWORD mapWidth, mapHeight;
+SDWORD scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
+uint8_t *psBlockMap[AUX_MAX];
+uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];
+UDWORD gameTime;
+
+static unsigned benchHumanPlayers = ~0u;  ///< All human, so no danger maps, unless replaying a trace.
+
+bool isHumanPlayer(int player)
+{
+	return (benchHumanPlayers >> player & 1) != 0;
+}
+
+/// Number of calls to operator new, for counting the allocations made while finding routes.
+static unsigned long benchAllocations;
+
+void *operator new(size_t size)
+{
+	++benchAllocations;
+	void *ptr = malloc(size != 0 ? size : 1);
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void _syncDebug(const char *, const char *, ...)
+{
+}
+
+static unsigned benchMaps, benchRoutes, benchReachable;
+static double benchSecondsJPS, benchSecondsAStar;
+
+/// Deterministic, so the same routes are found every run.
+static unsigned benchRand(unsigned &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static bool benchBlocked(int x, int y)
+{
+	return x < 1 || y < 1 || x >= mapWidth - 1 || y >= mapHeight - 1 || (psBlockMap[0][x + y * mapWidth] & (FEATURE_BLOCKED | WATER_BLOCKED)) != 0;
+}
+
+/// Checks that each step of the route is a straight line of open tiles.
+static bool benchCheckRoute(MOVE_CONTROL const &move)
+{
+	for (int i = 0; i + 1 < move.numPoints; ++i)
+	{
+		Vector2i a = map_coord(move.asPath[i]), b = map_coord(move.asPath[i + 1]);
+		Vector2i dir(clip(b.x - a.x, -1, 1), clip(b.y - a.y, -1, 1));
+		if (a.x != b.x && a.y != b.y && abs(b.x - a.x) != abs(b.y - a.y))
+		{
+			return false;
+		}
+		for (Vector2i p = a; p != b; p += dir)
+		{
+			if (benchBlocked(p.x + dir.x, p.y + dir.y) || benchBlocked(p.x + dir.x, p.y) || benchBlocked(p.x, p.y + dir.y))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static ASR_RETVAL benchRoute(PathfindCache *cache, PATHJOB &job, MOVE_CONTROL &move, double &seconds)
+{
+	fpathSetBlockingMap(&job);
+	move.asPath = NULL;
+	move.numPoints = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ASR_RETVAL retval = fpathAStarRoute(cache, &move, &job);
+	seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return retval;
+}
+
+bool pathBenchMap(const char *name, int width, int height, const uint8_t *blockBits, bool bench)
+{
+	std::vector<uint8_t> blockMap(blockBits, blockBits + width * height);
+	std::vector<uint8_t> auxMap(width * height, 0);
+	mapWidth = width;
+	mapHeight = height;
+	scrollMinX = 0;
+	scrollMinY = 0;
+	scrollMaxX = width;
+	scrollMaxY = height;
+	for (int i = 0; i < AUX_MAX; ++i)
+	{
+		psBlockMap[i] = &blockMap[0];
+	}
+	for (int i = 0; i < MAX_PLAYERS + AUX_MAX; ++i)
+	{
+		psAuxMap[i] = &auxMap[0];
+	}
+	++gameTime;  // Don't reuse blocking maps from the previous map.
+	fpathHardTableReset();
+
+	PathfindCache *cache = fpathCreateCache(PATHFIND_CACHE_SIZE);
+	PATHJOB job;
+	job.propulsion = PROPULSION_TYPE_WHEELED;
+	job.droidType = DROID_DEFAULT;
+	job.dstStructure = StructureBounds(Vector2i(0, 0), Vector2i(-1, -1));
+	job.droidID = 0;
+	job.owner = 0;
+	job.acceptNearest = true;
+	job.deleted = false;
+
+	bool ok = true;
+	unsigned seed = 1, reachable = 0;
+	double secondsJPS = 0, secondsAStar = 0;
+	unsigned numRoutes = bench ? BENCH_ROUTES : CHECK_ROUTES;
+	for (unsigned i = 0; i < numRoutes; ++i)
+	{
+		// Like fpathDroidRoute(), only route to open tiles, though they may not be reachable.
+		Vector2i orig, dest;
+		do
+		{
+			orig = Vector2i(benchRand(seed) % width, benchRand(seed) % height);
+		}
+		while (benchBlocked(orig.x, orig.y));
+		do
+		{
+			dest = Vector2i(benchRand(seed) % width, benchRand(seed) % height);
+		}
+		while (benchBlocked(dest.x, dest.y));
+		job.origX = world_coord(orig.x) + TILE_UNITS / 2;
+		job.origY = world_coord(orig.y) + TILE_UNITS / 2;
+		job.destX = world_coord(dest.x) + TILE_UNITS / 2;
+		job.destY = world_coord(dest.y) + TILE_UNITS / 2;
+
+		MOVE_CONTROL moveJPS, moveAStar;
+		job.moveType = FMT_MOVE;
+		ASR_RETVAL retJPS = benchRoute(cache, job, moveJPS, secondsJPS);
+		job.moveType = FMT_BLOCK;
+		ASR_RETVAL retAStar = benchRoute(cache, job, moveAStar, secondsAStar);
+
+		if (retJPS != retAStar || (retJPS == ASR_OK && !benchCheckRoute(moveJPS)))
+		{
+			fprintf(stderr, "pathbench: %s: Bad route from (%d, %d) to (%d, %d), results %d and %d\n", name, orig.x, orig.y, dest.x, dest.y, retJPS, retAStar);
+			ok = false;
+		}
+		reachable += retJPS == ASR_OK;
+		free(moveJPS.asPath);
+		free(moveAStar.asPath);
+	}
+	fpathDestroyCache(cache);
+	fpathHardTableReset();
+
+	printf("%-40s %3dx%-3d %3u/%u reachable, Jump Point Search %7.1f us/route, A* %7.1f us/route\n", name, width, height,
+	       reachable, numRoutes, secondsJPS * 1e6 / numRoutes, secondsAStar * 1e6 / numRoutes);
+	++benchMaps;
+	benchRoutes += numRoutes;
+	benchReachable += reachable;
+	benchSecondsJPS += secondsJPS;
+	benchSecondsAStar += secondsAStar;
+	return ok;
+}
+
+void pathBenchSummary()
+{
+	if (benchRoutes == 0)
+	{
+		return;
+	}
+	printf("Total: %u maps, %u/%u reachable, Jump Point Search %.1f us/route, A* %.1f us/route\n", benchMaps, benchReachable, benchRoutes,
+	       benchSecondsJPS * 1e6 / benchRoutes, benchSecondsAStar * 1e6 / benchRoutes);
+}
+
+static bool benchReadTrace(FILE *fp, uint32_t *values, unsigned count)
+{
+	for (unsigned i = 0; i < count; ++i)
+	{
+		uint8_t bytes[4];
+		if (fread(bytes, 1, 4, fp) != 4)
+		{
+			return false;
+		}
+		values[i] = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+	}
+	return true;
+}
+
+/// Applies the rest of an FPATH_TRACE_MAPS record.
+static bool benchReadTraceMaps(FILE *fp, std::vector<uint8_t> &maps)
+{
+	uint32_t header[6];
+	if (!benchReadTrace(fp, header, ARRAY_SIZE(header)))
+	{
+		return false;
+	}
+	gameTime = header[0];
+	scrollMinX = header[1];
+	scrollMinY = header[2];
+	scrollMaxX = header[3];
+	scrollMaxY = header[4];
+	benchHumanPlayers = header[5];
+
+	unsigned tiles = mapWidth * mapHeight;
+	uint32_t index, count, change[2];
+	while (benchReadTrace(fp, &index, 1) && index != 0xFFFFFFFF)
+	{
+		if (index >= FPATH_TRACE_NUM_MAPS || !benchReadTrace(fp, &count, 1))
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!benchReadTrace(fp, change, 2) || change[0] >= tiles)
+			{
+				return false;
+			}
+			maps[index * tiles + change[0]] = change[1];
+		}
+	}
+	return index == 0xFFFFFFFF;
+}
+
+bool pathBenchTrace(const char *traceName, int width, int height, const uint8_t *blockBits)
+{
+	FILE *fp = fopen(traceName, "rb");
+	if (!fp)
+	{
+		fprintf(stderr, "pathbench: Failed to open \"%s\"\n", traceName);
+		return false;
+	}
+	uint32_t header[5];
+	if (!benchReadTrace(fp, header, ARRAY_SIZE(header)) || header[0] != FPATH_TRACE_MAGIC || header[1] != FPATH_TRACE_VERSION)
+	{
+		fprintf(stderr, "pathbench: \"%s\" is not a version %d path job trace\n", traceName, FPATH_TRACE_VERSION);
+		fclose(fp);
+		return false;
+	}
+	if (header[2] != (uint32_t)width || header[3] != (uint32_t)height || header[4] != crcSum(0, blockBits, width * height))
+	{
+		fprintf(stderr, "pathbench: \"%s\" was recorded on a different map\n", traceName);
+		fclose(fp);
+		return false;
+	}
+
+	unsigned tiles = width * height;
+	std::vector<uint8_t> maps(FPATH_TRACE_NUM_MAPS * tiles, 0);
+	std::copy(blockBits, blockBits + tiles, maps.begin());
+	mapWidth = width;
+	mapHeight = height;
+	for (int i = 0; i < AUX_MAX; ++i)
+	{
+		psBlockMap[i] = &maps[i * tiles];
+	}
+	for (int i = 0; i < MAX_PLAYERS + AUX_MAX; ++i)
+	{
+		psAuxMap[i] = &maps[(AUX_MAX + i) * tiles];
+	}
+	fpathHardTableReset();
+
+	PathfindCache *caches[FPATH_LANES];
+	for (PathfindCache *&cache : caches)
+	{
+		cache = fpathCreateCache(FPATH_LANE_CACHE_SIZE);
+	}
+
+	bool ok = true;
+	unsigned jobs = 0, results[3] = {0, 0, 0};
+	unsigned long allocations = 0;
+	double seconds = 0;
+	uint32_t type;
+	while (ok && benchReadTrace(fp, &type, 1))
+	{
+		if (type == FPATH_TRACE_MAPS)
+		{
+			ok = benchReadTraceMaps(fp, maps);
+			continue;
+		}
+		uint32_t record[14];
+		if (type != FPATH_TRACE_JOB || !benchReadTrace(fp, record, ARRAY_SIZE(record)))
+		{
+			ok = false;
+			break;
+		}
+		PATHJOB job;
+		job.droidID = record[0];
+		job.origX = record[1];
+		job.origY = record[2];
+		job.destX = record[3];
+		job.destY = record[4];
+		job.dstStructure = StructureBounds(Vector2i((int32_t)record[5], (int32_t)record[6]), Vector2i((int32_t)record[7], (int32_t)record[8]));
+		job.propulsion = (PROPULSION_TYPE)record[9];
+		job.droidType = (DROID_TYPE)record[10];
+		job.moveType = (FPATH_MOVETYPE)record[11];
+		job.owner = record[12];
+		job.acceptNearest = record[13] != 0;
+		job.deleted = false;
+
+		// Run the jobs of each lane in order, like the pathfinding threads would.
+		MOVE_CONTROL move;
+		unsigned long allocationsBefore = benchAllocations;
+		ASR_RETVAL retval = benchRoute(caches[fpathJobLane(job)], job, move, seconds);
+		allocations += benchAllocations - allocationsBefore;
+		++results[retval];
+		++jobs;
+		free(move.asPath);
+	}
+	if (!ok)
+	{
+		fprintf(stderr, "pathbench: \"%s\" is corrupt after %u jobs\n", traceName, jobs);
+	}
+	fclose(fp);
+
+	unsigned nodesExpanded = 0, flowFieldsBuilt = 0, contextsReused = 0, contextsCreated = 0;
+	for (PathfindCache *cache : caches)
+	{
+		PathfindStats stats = fpathCacheStats(cache);
+		nodesExpanded += stats.nodesExpanded;
+		flowFieldsBuilt += stats.flowFieldsBuilt;
+		contextsReused += stats.contextsReused;
+		contextsCreated += stats.contextsCreated;
+		fpathDestroyCache(cache);
+	}
+	fpathHardTableReset();
+	benchHumanPlayers = ~0u;
+
+	unsigned divisor = std::max(jobs, 1u);
+	printf("%s: %u routes, %u found, %u nearest, %u failed\n", traceName, jobs, results[ASR_OK], results[ASR_NEAREST], results[ASR_FAILED]);
+	printf("%.0f ns/route, %.1f nodes expanded/route, %u flow fields built, %.1f allocations/route\n", seconds * 1e9 / divisor,
+	       (double)nodesExpanded / divisor, flowFieldsBuilt, (double)allocations / divisor);
+	printf("%u A* routes reused a cached context, %u made a new one, %u contexts per lane\n", contextsReused, contextsCreated,
+	       FPATH_LANE_CACHE_SIZE);
+	return ok;
+}
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+#include "map/mapload.h"
+#include "wavecastbench.h"
+
+int main(int argc, char **argv)
+{
+	char datapath[PATH_MAX];
+	bool ok = true;
+
+	PHYSFS_init(argv[0]);
+	strcpy(datapath, getenv("srcdir") != NULL ? getenv("srcdir") : ".");
+	strcat(datapath, "/../data");
+	PHYSFS_addToSearchPath(datapath, 1);
+
+	// Without arguments, as run by make check, only use enough viewers to check the results.
+	bool bench = argc == 2 && strcmp(argv[1], "--bench") == 0;
+	if (argc != 1 && !bench)
+	{
+		fprintf(stderr, "Usage: %s [--bench]\n", argv[0]);
+		return -1;
+	}
+
+	FILE *fp = fopen("maplist.txt", "r");
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Failed to open list file\n", argv[0]);
+		return -1;
+	}
+
+	while (!feof(fp))
+	{
+		GAMEMAP *map;
+		char filename[PATH_MAX], *delim;
+
+		if (fscanf(fp, "%254s\n", filename) != 1)
+		{
+			fprintf(stderr, "wavecastbench: Couldn't fscanf maplist.txt.\n");
+			return -1;
+		}
+
+		// Only skirmish maps, campaign maps are split up by scroll limits.
+		if (strncmp(filename, "mp/", 3) != 0)
+		{
+			continue;
+		}
+
+		// Strip "/game.map"
+		delim = strrchr(filename, '/');
+		if (!delim)
+		{
+			fprintf(stderr, "wavecastbench: Failed to find map directory for \"%s\"\n", filename);
+			return -1;
+		}
+		*delim = '\0';
+
+		map = mapLoad(filename);
+		if (!map)
+		{
+			fprintf(stderr, "wavecastbench: Failed to load \"%s\"\n", filename);
+			return -1;
+		}
+
+		std::vector<uint8_t> heights(map->width * map->height);
+		for (unsigned y = 0; y < map->height; ++y)
+		{
+			for (unsigned x = 0; x < map->width; ++x)
+			{
+				heights[x + y * map->width] = mapTile(map, x, y)->height;
+			}
+		}
+		ok = wavecastBenchMap(filename, map->width, map->height, &heights[0], bench) && ok;
+		mapFree(map);
+	}
+	fclose(fp);
+
+	wavecastBenchSummary();
+
+	return ok ? 0 : 1;
+}
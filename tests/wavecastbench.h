@@ -0,0 +1,15 @@
+#ifndef __INCLUDED_TESTS_WAVECASTBENCH_H__
+#define __INCLUDED_TESTS_WAVECASTBENCH_H__
+
+#include <stdint.h>
+
+// Kept apart from the map loader, since tools/map/mapload.h and src/map.h define the same names.
+
+/// Finds the tiles seen from viewers around a map with both the game's wavecast and the reference wavecast, where heights are the
+/// tile heights as stored in the map file. Returns false if they disagree. Only uses a few viewers unless bench is set.
+bool wavecastBenchMap(const char *name, int width, int height, const uint8_t *heights, bool bench);
+
+/// Prints the totals for all maps.
+void wavecastBenchSummary();
+
+#endif // __INCLUDED_TESTS_WAVECASTBENCH_H__
@@ -0,0 +1,196 @@
+/*
+ * Wavecast benchmark, the part which uses the game headers.
+ *
+ * Finds which tiles can be seen from the same viewer positions with wavecastVisibleTiles() from src/wavecast.cpp, and with the
+ * reference version below, which is how the game found them before. Both must find exactly the same tiles, in the same order.
+ */
+
+#include "lib/framework/frame.h"
+#include "src/map.h"
+#include "src/wavecast.h"
+#include "wavecastbench.h"
+
+#include <chrono>
+#include <vector>
+
+#define BENCH_VIEWERS	500	///< Number of viewers on each map, when benchmarking.
+#define BENCH_REPEATS	5	///< Number of times to find the tiles seen by all viewers with each version, keeping the fastest time.
+#define CHECK_VIEWERS	50	///< Number of viewers on each map, when only checking that both versions agree.
+
+struct BenchViewer
+{
+	Vector3i pos;
+	unsigned radius;
+};
+
+static unsigned benchMaps, benchViewers, benchTilesSeen;
+static double benchSecondsGame, benchSecondsReference;
+
+/// Deterministic, so the same viewers are used every run.
+static unsigned benchRand(unsigned &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+#define MAX_WAVECAST_LIST_SIZE 1360  // Same as in wavecast.cpp.
+
+/// The wavecast as it was in doWaveTerrain(), before it was moved to wavecast.cpp and made branch free.
+static void referenceVisibleTiles(MAPTILE const *mapTiles, int width, int height, Vector3i viewer, unsigned radius, std::vector<Vector2i> &seenTiles)
+{
+	const int sx = viewer.x;
+	const int sy = viewer.y;
+	const int sz = viewer.z;
+	size_t size;
+	const WavecastTile *tiles = getWavecastTable(radius, &size);
+	int heights[2][MAX_WAVECAST_LIST_SIZE];
+	int angles[2][MAX_WAVECAST_LIST_SIZE + 1];
+	int readListSize = 0, readListPos = 0, writeListPos = 0;  // readListSize, readListPos dummy initialisations.
+	int readList = 0;  // Reading from this list, writing to the other. Could also initialise to rand()%2.
+	int lastHeight = 0;  // lastHeight dummy initialisation.
+	int lastAngle = 0x7FFFFFFF;
+
+	// Start with full vision of all angles.
+	heights[!readList][writeListPos] = -0x7FFFFFFF - 1; // Smallest integer.
+	angles[!readList][writeListPos] = 0;               // Smallest angle.
+	++writeListPos;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		const int mapX = map_coord(sx) + tiles[i].dx;
+		const int mapY = map_coord(sy) + tiles[i].dy;
+		if (mapX < 0 || mapX >= width || mapY < 0 || mapY >= height)
+		{
+			continue;
+		}
+
+		MAPTILE const *psTile = &mapTiles[mapX + mapY * width];
+		int tileHeight = std::max(psTile->height, psTile->waterLevel);  // If we can see the water surface, then let us see water-covered tiles too.
+		int perspectiveHeight = (tileHeight - sz) * tiles[i].invRadius;
+		int perspectiveHeightLeeway = (tileHeight - sz + MIN_VIS_HEIGHT) * tiles[i].invRadius;
+
+		if (tiles[i].angBegin < lastAngle)
+		{
+			// Gone around the circle. (Or just started scan.)
+			angles[!readList][writeListPos] = lastAngle;
+
+			// Flip the lists.
+			readList = !readList;
+			readListPos = 0;
+			readListSize = writeListPos;
+			writeListPos = 0;
+			lastHeight = 1;  // Impossible value since tiles[i].invRadius > 1 for all i, so triggers writing first entry in list.
+		}
+		lastAngle = tiles[i].angEnd;
+
+		while (angles[readList][readListPos + 1] <= tiles[i].angBegin && readListPos < readListSize)
+		{
+			++readListPos;  // Skip, not relevant.
+		}
+
+		bool seen = false;
+		while (angles[readList][readListPos] < tiles[i].angEnd && readListPos < readListSize)
+		{
+			int oldHeight = heights[readList][readListPos];
+			int newHeight = MAX(oldHeight, perspectiveHeight);
+			seen = seen || perspectiveHeightLeeway >= oldHeight; // consider point slightly above ground in case there is something on the tile
+			if (newHeight != lastHeight)
+			{
+				heights[!readList][writeListPos] = newHeight;
+				angles[!readList][writeListPos] = MAX(angles[readList][readListPos], tiles[i].angBegin);
+				lastHeight = newHeight;
+				++writeListPos;
+				ASSERT_OR_RETURN(, writeListPos <= MAX_WAVECAST_LIST_SIZE, "Visibility too complicated! Need to increase MAX_WAVECAST_LIST_SIZE.");
+			}
+			++readListPos;
+		}
+		--readListPos;
+
+		if (seen)
+		{
+			seenTiles.push_back(Vector2i(mapX, mapY));
+		}
+	}
+}
+
+typedef void (*BenchWavecast)(MAPTILE const *mapTiles, int width, int height, Vector3i viewer, unsigned radius, std::vector<Vector2i> &seenTiles);
+
+/// Finds the tiles seen by all the viewers, and returns the fastest time of repeats runs.
+static double benchWavecast(BenchWavecast wavecast, std::vector<MAPTILE> const &mapTiles, int width, int height, std::vector<BenchViewer> const &viewers, int repeats, std::vector<std::vector<Vector2i>> &seenTiles)
+{
+	double best = 0;
+	seenTiles.resize(viewers.size());
+	for (int repeat = 0; repeat < repeats; ++repeat)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < viewers.size(); ++i)
+		{
+			seenTiles[i].clear();
+			wavecast(&mapTiles[0], width, height, viewers[i].pos, viewers[i].radius, seenTiles[i]);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = repeat == 0 ? seconds : std::min(best, seconds);
+	}
+	return best;
+}
+
+bool wavecastBenchMap(const char *name, int width, int height, const uint8_t *heights, bool bench)
+{
+	// Same tile and water heights as set by mapLoad() in src/map.cpp, without the riverbeds.
+	std::vector<MAPTILE> mapTiles(width * height);
+	for (int i = 0; i < width * height; ++i)
+	{
+		mapTiles[i].height = heights[i] * ELEVATION_SCALE;
+		mapTiles[i].waterLevel = mapTiles[i].height - world_coord(1) / 3;
+	}
+
+	// Viewers standing on the middle of random tiles, with the sensor ranges in mp/stats/sensor.json, and one upgraded range.
+	static const unsigned radii[] = {640, 1024, 1536, 2048, 2304, 3072, 4608};
+	unsigned numViewers = bench ? BENCH_VIEWERS : CHECK_VIEWERS;
+	int repeats = bench ? BENCH_REPEATS : 1;
+	std::vector<BenchViewer> viewers(numViewers);
+	unsigned seed = 1;
+	for (unsigned i = 0; i < viewers.size(); ++i)
+	{
+		int x = benchRand(seed) % width, y = benchRand(seed) % height;
+		viewers[i].pos = Vector3i(world_coord(x) + TILE_UNITS / 2, world_coord(y) + TILE_UNITS / 2, mapTiles[x + y * width].height + MIN_VIS_HEIGHT);
+		viewers[i].radius = radii[benchRand(seed) % ARRAY_SIZE(radii)];
+		prepareWavecastTable(viewers[i].radius);
+	}
+
+	std::vector<std::vector<Vector2i>> seenGame, seenReference;
+	double secondsGame = benchWavecast(wavecastVisibleTiles, mapTiles, width, height, viewers, repeats, seenGame);
+	double secondsReference = benchWavecast(referenceVisibleTiles, mapTiles, width, height, viewers, repeats, seenReference);
+
+	bool ok = true;
+	unsigned tilesSeen = 0;
+	for (unsigned i = 0; i < viewers.size(); ++i)
+	{
+		if (seenGame[i] != seenReference[i])
+		{
+			fprintf(stderr, "wavecastbench: %s: Different tiles seen from (%d, %d, %d) with radius %u, %u and %u tiles\n", name, viewers[i].pos.x, viewers[i].pos.y,
+			        viewers[i].pos.z, viewers[i].radius, (unsigned)seenGame[i].size(), (unsigned)seenReference[i].size());
+			ok = false;
+		}
+		tilesSeen += seenReference[i].size();
+	}
+
+	printf("%-40s %3dx%-3d %7u tiles seen, wavecast %6.2f us/viewer, reference %6.2f us/viewer\n", name, width, height, tilesSeen,
+	       secondsGame * 1e6 / numViewers, secondsReference * 1e6 / numViewers);
+	++benchMaps;
+	benchViewers += numViewers;
+	benchTilesSeen += tilesSeen;
+	benchSecondsGame += secondsGame;
+	benchSecondsReference += secondsReference;
+	return ok;
+}
+
+void wavecastBenchSummary()
+{
+	if (benchViewers == 0)
+	{
+		return;
+	}
+	printf("Total: %u maps, %u viewers, %u tiles seen, wavecast %.2f us/viewer, reference %.2f us/viewer\n", benchMaps, benchViewers, benchTilesSeen,
+	       benchSecondsGame * 1e6 / benchViewers, benchSecondsReference * 1e6 / benchViewers);
+}